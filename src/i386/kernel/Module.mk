@@ -4,6 +4,7 @@ SOURCES := \
     entry.S \
     cpu.c \
     crash.c \
+    dispatch.c \
     gdbstub.c \
     pgtbl.c \
     pic.c \
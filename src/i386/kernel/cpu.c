@@ -57,6 +57,11 @@
 #define CPUID_PGE               (1 << 13)
 #define CPUID_PAT               (1 << 16)
 
+//
+// CPUID.EAX=07h,ECX=0 EBX return bits.
+//
+#define CPUID_ERMS              (1 << 9)
+
 static void setup_ldt(void);
 static void setup_tss(void);
 static void setup_idt(void);
@@ -261,6 +266,9 @@ bool get_cpu_info(struct cpuid *info)
     info->vendor_id[12] = '\0';
     info->level = eax;
 
+    // CPUID arrived with the late 486s, so INVLPG is always there if we got
+    // this far; a CPU without CPUID may still be a 486, but we can't tell
+    info->invlpg_support = true;
 
     if (info->level >= 1) {
         __cpuid(0x1, eax, ebx, ecx, edx);
@@ -288,6 +296,11 @@ bool get_cpu_info(struct cpuid *info)
         info->brand_index = ebx & 0xFF;
     }
 
+    if (info->level >= 7) {
+        __cpuid_count(0x7, 0x0, eax, ebx, ecx, edx);
+        info->erms_support = ebx & CPUID_ERMS;
+    }
+
     __cpuid(0x80000000, eax, ebx, ecx, edx);
     if (eax & 0x80000000) {
         info->level_extended = eax;
@@ -194,6 +194,8 @@ __noreturn void handle_soft_double_fault(
 {
     char msgbuf[CRASH_BUFSIZ];
 
+    console_sync();
+
     cprint("\n\n\e[1m" RED("*** FATAL: exception (1) occurred while handling previous exception (2)"));
     cprint("\n\n(1) %s at %08X", exception_names[cpu->iregs.vec], cpu->iregs.eip);
     dump_cpu(cpu, cprint);
@@ -246,6 +248,9 @@ __fastcall void handle_exception(struct iregs *iregs)
     crashing = true;
     orig_cpu = cpu;
 
+    // interrupts are off from here on, so consoles have to poll
+    console_sync();
+
 #if DEBUG
     // test a software double fault
     if (g_test_soft_double_fault) {
@@ -432,6 +437,10 @@ static int cprint(const char *fmt, ...)
     count = vsnprintf(buf, CRASH_BUFSIZ, fmt, args);
     va_end(args);
 
+    if (count >= CRASH_BUFSIZ) {
+        count = CRASH_BUFSIZ - 1;   // truncated
+    }
+
     if (has_console()) {
         return console_write(buf, count);
     }
@@ -449,6 +458,10 @@ static int fbprint(const char *fmt, ...)
     count = vsnprintf(buf, CRASH_BUFSIZ, fmt, args);
     va_end(args);
 
+    if (count >= CRASH_BUFSIZ) {
+        count = CRASH_BUFSIZ - 1;   // truncated
+    }
+
     return fbwrite(buf, count);
 }
 
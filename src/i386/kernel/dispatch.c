@@ -0,0 +1,268 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: i386/kernel/dispatch.c
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * -----------------------------------------------------------------------------
+ * Boot-time selection of CPU-specific routines. Each op has a table of
+ * implementations ordered from slowest to fastest; the fastest one the CPU can
+ * run gets plugged into g_cpu_ops.
+ * =============================================================================
+ */
+
+#include <string.h>
+#include <i386/cpu.h>
+#include <i386/dispatch.h>
+#include <i386/paging.h>
+#include <i386/x86.h>
+#include <kernel/kernel.h>
+#include <kernel/ohwes.h>
+
+//
+// memcpy
+//
+
+static __noloopcall void * bytes_memcpy(void *dst, const void *src, size_t count)
+{
+    unsigned char *d = dst;
+    const unsigned char *s = src;
+
+    while (count--) {
+        *d++ = *s++;
+    }
+    return dst;
+}
+
+static void * movsb_memcpy(void *dst, const void *src, size_t count)
+{
+    void *d = dst;
+
+    __asm__ volatile (
+        "rep movsb"
+        : "+D"(d), "+S"(src), "+c"(count)
+        :: "memory"
+    );
+    return dst;
+}
+
+//
+// memset
+//
+
+static __noloopcall void * bytes_memset(void *dst, int c, size_t count)
+{
+    unsigned char *d = dst;
+
+    while (count--) {
+        *d++ = (unsigned char) c;
+    }
+    return dst;
+}
+
+static void * stosb_memset(void *dst, int c, size_t count)
+{
+    void *d = dst;
+
+    __asm__ volatile (
+        "rep stosb"
+        : "+D"(d), "+c"(count)
+        : "a"(c)
+        : "memory"
+    );
+    return dst;
+}
+
+//
+// zero_page
+//
+
+static __noloopcall void bytes_zero_page(void *page)
+{
+    unsigned char *p = page;
+
+    for (int i = 0; i < PAGE_SIZE; i++) {
+        p[i] = 0;
+    }
+}
+
+static void stosl_zero_page(void *page)
+{
+    size_t count = PAGE_SIZE / sizeof(uint32_t);
+
+    __asm__ volatile (
+        "rep stosl"
+        : "+D"(page), "+c"(count)
+        : "a"(0)
+        : "memory"
+    );
+}
+
+static void stosb_zero_page(void *page)
+{
+    size_t count = PAGE_SIZE;
+
+    __asm__ volatile (
+        "rep stosb"
+        : "+D"(page), "+c"(count)
+        : "a"(0)
+        : "memory"
+    );
+}
+
+//
+// flush_pages
+//
+
+static void cr3_flush_pages(const uint32_t *va, int count)
+{
+    (void) va;
+
+    if (count > 0) {
+        flush_tlb();
+    }
+}
+
+static void invlpg_flush_pages(const uint32_t *va, int count)
+{
+    for (int i = 0; i < count; i++) {
+        flush_tlb_page(va[i]);
+    }
+}
+
+//
+// implementation tables, slowest first
+//
+
+static const struct cpu_impl _memcpy_impls[] = {
+    { "bytes",          0,                  bytes_memcpy },
+    { "rep movsl",      0,                  memcpy },
+    { "rep movsb",      CPU_FEAT_ERMS,      movsb_memcpy },
+};
+
+static const struct cpu_impl _memset_impls[] = {
+    { "bytes",          0,                  bytes_memset },
+    { "rep stosl",      0,                  memset },
+    { "rep stosb",      CPU_FEAT_ERMS,      stosb_memset },
+};
+
+static const struct cpu_impl _zero_page_impls[] = {
+    { "bytes",          0,                  bytes_zero_page },
+    { "rep stosl",      0,                  stosl_zero_page },
+    { "rep stosb",      CPU_FEAT_ERMS,      stosb_zero_page },
+};
+
+static const struct cpu_impl _flush_pages_impls[] = {
+    { "mov cr3",        0,                  cr3_flush_pages },
+    { "invlpg",         CPU_FEAT_INVLPG,    invlpg_flush_pages },
+};
+
+static const struct {
+    const char *name;
+    const struct cpu_impl *impls;
+    int count;
+} _ops[NR_CPU_OPS] = {
+    [CPU_OP_MEMCPY]      = { "memcpy",      _memcpy_impls,      countof(_memcpy_impls) },
+    [CPU_OP_MEMSET]      = { "memset",      _memset_impls,      countof(_memset_impls) },
+    [CPU_OP_ZERO_PAGE]   = { "zero_page",   _zero_page_impls,   countof(_zero_page_impls) },
+    [CPU_OP_FLUSH_PAGES] = { "flush_pages", _flush_pages_impls, countof(_flush_pages_impls) },
+};
+
+// safe on any 386 until init_cpu_ops() runs
+struct cpu_ops g_cpu_ops = {
+    .memcpy = memcpy,
+    .memset = memset,
+    .zero_page = stosl_zero_page,
+    .flush_pages = cr3_flush_pages,
+};
+
+static uint32_t _cpu_features;
+static const struct cpu_impl *_selected[NR_CPU_OPS];
+
+void init_cpu_ops(void)
+{
+    struct cpuid cpu;
+
+    _cpu_features = 0;
+    if (get_cpu_info(&cpu)) {
+        if (cpu.invlpg_support) _cpu_features |= CPU_FEAT_INVLPG;
+        if (cpu.erms_support) _cpu_features |= CPU_FEAT_ERMS;
+    }
+
+    for (int op = 0; op < NR_CPU_OPS; op++) {
+        const struct cpu_impl *best = NULL;
+        for (int i = 0; i < _ops[op].count; i++) {
+            if (cpu_impl_usable(&_ops[op].impls[i])) {
+                best = &_ops[op].impls[i];
+            }
+        }
+        assert(best != NULL);
+        _selected[op] = best;
+
+        switch (op) {
+            case CPU_OP_MEMCPY:
+                g_cpu_ops.memcpy = (memcpy_fn) best->fn;
+                break;
+            case CPU_OP_MEMSET:
+                g_cpu_ops.memset = (memset_fn) best->fn;
+                break;
+            case CPU_OP_ZERO_PAGE:
+                g_cpu_ops.zero_page = (zero_page_fn) best->fn;
+                break;
+            case CPU_OP_FLUSH_PAGES:
+                g_cpu_ops.flush_pages = (flush_pages_fn) best->fn;
+                break;
+        }
+
+        kprint("cpu-ops: %s: %s\n", _ops[op].name, best->name);
+    }
+}
+
+uint32_t get_cpu_features(void)
+{
+    return _cpu_features;
+}
+
+const struct cpu_impl * get_cpu_impls(enum cpu_op op, int *count)
+{
+    if (op < 0 || op >= NR_CPU_OPS) {
+        *count = 0;
+        return NULL;
+    }
+
+    *count = _ops[op].count;
+    return _ops[op].impls;
+}
+
+bool cpu_impl_usable(const struct cpu_impl *impl)
+{
+    return (impl->features & ~_cpu_features) == 0;
+}
+
+const char * get_cpu_op_name(enum cpu_op op)
+{
+    if (op < 0 || op >= NR_CPU_OPS) {
+        return NULL;
+    }
+    return _ops[op].name;
+}
+
+const char * get_cpu_impl_name(enum cpu_op op)
+{
+    if (op < 0 || op >= NR_CPU_OPS || _selected[op] == NULL) {
+        return NULL;
+    }
+    return _selected[op]->name;
+}
@@ -21,10 +21,33 @@
 
 #include <kernel/kernel.h>
 #include <kernel/mm.h>
+#include <kernel/trace.h>
 #include <i386/cpu.h>
+#include <i386/dispatch.h>
 #include <i386/paging.h>
 #include <i386/x86.h>
 
+static bool _large_pages;    // CR4.PSE enabled
+
+bool enable_large_pages(void)
+{
+    struct cpuid cpu;
+    uint32_t cr4;
+
+    if (!_large_pages) {
+        if (!get_cpu_info(&cpu) || !cpu.pse_support) {
+            return false;
+        }
+
+        store_cr4(cr4);
+        cr4 |= CR4_PSE;
+        load_cr4(cr4);
+        _large_pages = true;
+    }
+
+    return true;
+}
+
 bool virt_addr_valid(void *va)
 {
     pte_t *pte;
@@ -50,16 +73,116 @@ bool walk_page_table(uint32_t va, pte_t **pte)
         return false;
     }
 
+    // large pages have no page table, the PDE is the leaf
+    if (pde_large(*pde)) {
+        *pte = (pte_t *) pde;
+        return true;
+    }
+
     *pte = (pte_t *) KERNEL_ADDR(pte_offset(pde, va));
     return true;
 }
 
+// record a page whose old translation may be cached in the TLB
+static void batch_invalidate(struct map_batch *batch, uint32_t va)
+{
+    if (batch->count < MAP_BATCH_SIZE) {
+        batch->va[batch->count] = va;
+    }
+    else {
+        batch->flush_all = true;
+    }
+    batch->count++;
+}
+
+// break a large page into a page table that maps the same 4M with 4K pages
+static void split_large_page(struct map_batch *batch, pde_t *pde)
+{
+    pte_t *pgtbl;
+    uint32_t base;
+    pgflags_t attr;
+
+    pgtbl = (pte_t *) alloc_pgtbl();
+    if (pgtbl == NULL) {
+        panic("mem: out of memory for page table! pde(%08X)\n", *pde);
+    }
+
+    base = *pde & LARGE_PAGE_MASK;
+    attr = *pde & (_PAGE_RW | _PAGE_USER | _PAGE_PWT | _PAGE_PCD | _PAGE_GLOBAL);
+    for (int i = 0; i < PTE_COUNT; i++) {
+        pgtbl[i] = __mkpte(base + (i << PAGE_SHIFT), attr);
+    }
+
+    *pde = __mkpde(PHYSICAL_ADDR(pgtbl), _PAGE_RW | (attr & _PAGE_USER));
+    batch->flush_all = true;    // page size changed, play it safe
+}
+
+void map_batch_init(struct map_batch *batch)
+{
+    batch->count = 0;
+    batch->flush_all = false;
+}
+
+void map_batch_add(struct map_batch *batch, uint32_t va, uint32_t pa, pgflags_t flags)
+{
+    pde_t *pde;
+    pte_t *pte;
+    bool unmap;
+
+    flags &= ~_PAGE_LARGE;  // PAT bit in a PTE
+    unmap = (flags == 0);
+
+    pde = (pde_t *) KERNEL_ADDR(pde_offset((pde_t *) get_pgdir(), va));
+    if (pde_present(*pde) && pde_large(*pde)) {
+        split_large_page(batch, pde);
+    }
+    if (!pde_present(*pde)) {
+        if (unmap) {
+            return;     // nothing to unmap
+        }
+
+        // need a new page table; access is controlled by the PTEs
+        void *pgtbl = alloc_pgtbl();
+        if (pgtbl == NULL) {
+            panic("mem: out of memory for page table! pa(%08X) va(%08X)\n", pa, va);
+        }
+        *pde = __mkpde(PHYSICAL_ADDR(pgtbl), _PAGE_RW | (flags & _PAGE_USER));
+    }
+    pte = (pte_t *) KERNEL_ADDR(pte_offset(pde, va));
+
+    // the TLB never caches non-present entries, so only a page that was
+    // mapped before needs to be invalidated
+    if (pte_present(*pte)) {
+        batch_invalidate(batch, va);
+    }
+
+    pte_clear(pte);
+    if (!unmap) {   // map
+        *pte = __mkpte(pa, flags);
+    }
+}
+
+void map_batch_commit(struct map_batch *batch)
+{
+    // invlpg is cheap per page, but past a handful of pages a full flush
+    // (and the misses that follow it) costs less
+    if (batch->flush_all) {
+        flush_tlb();
+    }
+    else {
+        g_cpu_ops.flush_pages(batch->va, batch->count);
+    }
+
+    map_batch_init(batch);
+}
+
 void update_page_mappings(uint32_t va, uint32_t pa, size_t count, pgflags_t flags)
 {
+    struct map_batch batch;
     pde_t *pgdir;
     pde_t *pde;
-    pte_t *pte;
     bool unmap;
+    bool large;
 
     // TODO: these "page mappings" should probably be managed somewhere in a
     // structure if we're going to be "updating" them. So we can disallow
@@ -70,44 +193,56 @@ void update_page_mappings(uint32_t va, uint32_t pa, size_t count, pgflags_t flag
     //       or warn about double-mapping?
 
     pgdir = (pde_t *) get_pgdir();
+    large = (flags & _PAGE_LARGE) && _large_pages;
+    flags &= ~_PAGE_LARGE;
     unmap = (flags == 0);
     // TODO: check/validate/filter flags
 
-    if (count > 4096) {
-        assert(count <= 4096);
-        return;
-    }
-
     uintptr_t base_pa = pa;
     uintptr_t base_va = va;
 
+    map_batch_init(&batch);
     for (int i = 0; i < count; i++) {
         pde = (pde_t *) KERNEL_ADDR(pde_offset(pgdir, va));
-        if (!pde_present(*pde)) {
-            // TODO: map a new PDE and associated page table...
-            panic("phys-mem: mappings that require a new PDE and page table not yet implemented! pa(%08X) va(%08X)\n", pa, va);
+
+        // map or unmap a whole 4M chunk with a single PDE where we can
+        if ((large || unmap) && count - i >= PTE_COUNT
+            && (va & ~LARGE_PAGE_MASK) == 0 && (pa & ~LARGE_PAGE_MASK) == 0
+            && (!pde_present(*pde) || pde_large(*pde))) {
+            if (pde_present(*pde)) {
+                batch_invalidate(&batch, va);
+            }
+            pde_clear(pde);
+            if (!unmap) {
+                *pde = __mkpde_large(pa, flags);
+            }
+            i += PTE_COUNT - 1;
+            va += LARGE_PAGE_SIZE;
+            pa += LARGE_PAGE_SIZE;
+            continue;
         }
-        pte = (pte_t *) KERNEL_ADDR(pte_offset(pde, va));
 
-        pte_clear(pte);
-        if (!unmap) {   // map
-            *pte = __mkpte(pa, flags);
+        if (unmap && !pde_present(*pde)) {
+            // nothing mapped here, skip ahead to the next page table
+            int skip = PTE_COUNT - __ptn(va);
+            i += skip - 1;
+            va += skip << PAGE_SHIFT;
+            pa += skip << PAGE_SHIFT;
+            continue;
         }
 
+        map_batch_add(&batch, va, pa, flags);
         va += PAGE_SIZE;
         pa += PAGE_SIZE;
     }
+    map_batch_commit(&batch);
 
-    // TODO: be able to control this w/ flag
-    flush_tlb();
-
-    size_t size_bytes = (count << PAGE_SHIFT);
     if (unmap) {
-        kprint("mem: unmap p:%08X-%08X v:%08X-%08X size_pages=%d flags=%02Xh\n",
-            base_pa, base_pa+size_bytes-1, base_va, base_va+size_bytes-1, count, flags);
+        trace("mem: unmap p:%08X v:%08X size_pages=%d flags=%02Xh",
+            base_pa, base_va, count, flags);
     }
     else {
-        kprint("mem: map p:%08X-%08X v:%08X-%08X size_pages=%d flags=%02Xh\n",
-            base_pa, base_pa+size_bytes-1, base_va, base_va+size_bytes-1, count, flags);
+        trace("mem: map p:%08X v:%08X size_pages=%d flags=%02Xh",
+            base_pa, base_va, count, flags);
     }
 }
@@ -27,6 +27,7 @@
 #include <i386/x86.h>
 #include <kernel/irq.h>
 #include <kernel/ohwes.h>
+#include <kernel/wait.h>
 
 #define PIT_PORT_CHAN0              0x40
 #define PIT_PORT_CHAN1              0x41
@@ -61,6 +62,8 @@ struct pit_state {
 static struct pit_state _pit = { };
 struct pit_state *g_pit = &_pit;
 
+static struct wait_queue beep_wait = WAIT_QUEUE_INITIALIZER;
+
 static uint16_t calculate_divisor(int freq);
 void timer_interrupt(int irq, struct iregs *regs);
 
@@ -137,7 +140,9 @@ void beep(int hz, int ms, bool block)
 
     restore_flags(flags);
 
-    while (block && g_pit->pcspk_ticks > 0);
+    if (block) {
+        wait_event(&beep_wait, g_pit->pcspk_ticks == 0);
+    }
 }
 
 void timer_interrupt(int irq, struct iregs *regs)
@@ -151,6 +156,7 @@ void timer_interrupt(int irq, struct iregs *regs)
         g_pit->pcspk_ticks--;
         if (!g_pit->pcspk_ticks) {
             pcspk_off();
+            wake_up(&beep_wait);
         }
     }
 }
@@ -22,6 +22,8 @@
 #ifndef __BITOPS_H
 #define __BITOPS_H
 
+#include <stdint.h>
+
 /**
  * Set a bit in a bitstring.
  *
@@ -194,4 +196,163 @@ static inline int bit_scan_forward(volatile void *addr, unsigned int size)
     return (dword_index << 5) + bit_index;
 }
 
+/**
+ * Get the index of the lowest set bit in a DWORD. Undefined if the DWORD is
+ * zero.
+ *
+ * @param x the DWORD to scan
+ * @return index of the lowest set bit
+ */
+static inline unsigned int __bsf(uint32_t x)
+{
+    unsigned int index;
+    __asm__ ("bsfl %1, %0" : "=r"(index) : "rm"(x));
+    return index;
+}
+
+/**
+ * Fill a run of DWORDs with a value using REP STOSL.
+ *
+ * @param addr address of the first DWORD
+ * @param value value to store
+ * @param count number of DWORDs to fill
+ */
+static inline void __fill_dwords(volatile uint32_t *addr, uint32_t value, unsigned int count)
+{
+    __asm__ volatile (
+        "rep stosl"
+        : "+D"(addr), "+c"(count)
+        : "a"(value)
+        : "memory"
+    );
+}
+
+/**
+ * Set a range of bits in a bitstring. The unaligned head and tail are masked
+ * in, whole DWORDs in the middle are filled in one go. Not atomic!
+ *
+ * @param addr bitstring address; must be DWORD-aligned
+ * @param start index of the first bit to set
+ * @param count number of bits to set
+ */
+static inline void set_bit_range(volatile void *addr, unsigned int start, unsigned int count)
+{
+    volatile uint32_t *p = ((volatile uint32_t *) addr) + (start >> 5);
+    unsigned int head = start & 31;
+
+    if (count == 0) {
+        return;
+    }
+
+    if (head) {
+        unsigned int n = (count < 32 - head) ? count : 32 - head;
+        *p++ |= ((1U << n) - 1) << head;
+        count -= n;
+    }
+    if (count >= 32) {
+        __fill_dwords(p, 0xFFFFFFFF, count >> 5);
+        p += count >> 5;
+        count &= 31;
+    }
+    if (count) {
+        *p |= (1U << count) - 1;
+    }
+}
+
+/**
+ * Clear a range of bits in a bitstring. The unaligned head and tail are masked
+ * out, whole DWORDs in the middle are zeroed in one go. Not atomic!
+ *
+ * @param addr bitstring address; must be DWORD-aligned
+ * @param start index of the first bit to clear
+ * @param count number of bits to clear
+ */
+static inline void clear_bit_range(volatile void *addr, unsigned int start, unsigned int count)
+{
+    volatile uint32_t *p = ((volatile uint32_t *) addr) + (start >> 5);
+    unsigned int head = start & 31;
+
+    if (count == 0) {
+        return;
+    }
+
+    if (head) {
+        unsigned int n = (count < 32 - head) ? count : 32 - head;
+        *p++ &= ~(((1U << n) - 1) << head);
+        count -= n;
+    }
+    if (count >= 32) {
+        __fill_dwords(p, 0, count >> 5);
+        p += count >> 5;
+        count &= 31;
+    }
+    if (count) {
+        *p &= ~((1U << count) - 1);
+    }
+}
+
+/**
+ * Find the next set bit in a bitstring, starting at a given bit. Scans one
+ * DWORD at a time.
+ *
+ * @param addr bitstring address; must be DWORD-aligned
+ * @param size number of bits in bitstring
+ * @param start index of the first bit to consider
+ * @return index of the next set bit, or -1 if none are set in [start, size)
+ */
+static inline int find_next_set_bit(volatile void *addr, unsigned int size, unsigned int start)
+{
+    volatile uint32_t *p = ((volatile uint32_t *) addr) + (start >> 5);
+    unsigned int base = start & ~31;
+    uint32_t dword;
+
+    if (start >= size) {
+        return -1;
+    }
+
+    dword = *p & (0xFFFFFFFF << (start & 31));
+    while (dword == 0) {
+        base += 32;
+        if (base >= size) {
+            return -1;
+        }
+        dword = *++p;
+    }
+
+    base += __bsf(dword);
+    return (base < size) ? (int) base : -1;
+}
+
+/**
+ * Find the next zero bit in a bitstring, starting at a given bit. Scans one
+ * DWORD at a time.
+ *
+ * @param addr bitstring address; must be DWORD-aligned
+ * @param size number of bits in bitstring
+ * @param start index of the first bit to consider
+ * @return index of the next zero bit, or -1 if all are set in [start, size)
+ */
+static inline int find_next_zero_bit(volatile void *addr, unsigned int size, unsigned int start)
+{
+    volatile uint32_t *p = ((volatile uint32_t *) addr) + (start >> 5);
+    unsigned int base = start & ~31;
+    uint32_t dword;
+
+    if (start >= size) {
+        return -1;
+    }
+
+    dword = ~*p & (0xFFFFFFFF << (start & 31));
+    while (dword == 0) {
+        base += 32;
+        if (base >= size) {
+            return -1;
+        }
+        dword = ~*++p;
+    }
+
+    base += __bsf(dword);
+    return (base < size) ? (int) base : -1;
+}
+
 #endif // __BITOPS_H
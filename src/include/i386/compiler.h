@@ -53,13 +53,30 @@
  * Align fields in a data structure to the nearest n bytes, where n is a power
  * of 2.
  */
-#define __align(n)      __attribute__((aligned(n)))
+#define __align(n)      __attribute__((__aligned__(n)))
 
 /**
  * Indicate that a function does not return.
  */
 #define __noreturn      __attribute__((noreturn))
 
+/**
+ * Allow a type to alias any other type, e.g. for word-at-a-time memory access.
+ */
+#define __may_alias     __attribute__((may_alias))
+
+/**
+ * Keep GCC from turning a simple loop into a call to memcpy, memset, etc.;
+ * for code that implements or is measured against those functions.
+ */
+#define __noloopcall    __attribute__((optimize("no-tree-loop-distribute-patterns")))
+
+/**
+ * Compiler memory barrier. Keeps GCC from caching memory values in registers
+ * or moving loads and stores across this point. Emits no instructions.
+ */
+#define barrier()       __asm__ volatile ("" ::: "memory")
+
 #endif  // __GNUC__
 
 #endif  // __COMPILER_H
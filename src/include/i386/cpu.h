@@ -55,6 +55,8 @@ struct cpuid    // TODO: move to cpuid.h or something
     bool pat_support;           // page attribute table support (CR4.PAT bit)
     bool tsc_support;           // cpu has RDTSC instruction
     bool msr_support;           // cpu has RDMSR/WRMSR instrctions
+    bool invlpg_support;        // cpu has INVLPG instruction (486 and up)
+    bool erms_support;          // fast REP MOVSB/STOSB (Enhanced REP MOVSB)
 };
 
 struct cpu_state {
@@ -0,0 +1,88 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: include/i386/dispatch.h
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * =============================================================================
+ */
+
+#ifndef __DISPATCH_H
+#define __DISPATCH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+//
+// CPU features an implementation may depend on.
+//
+#define CPU_FEAT_INVLPG     (1 << 0)    // INVLPG instruction
+#define CPU_FEAT_ERMS       (1 << 1)    // fast REP MOVSB/STOSB
+
+typedef void * (*memcpy_fn)(void *dst, const void *src, size_t count);
+typedef void * (*memset_fn)(void *dst, int c, size_t count);
+typedef void (*zero_page_fn)(void *page);
+typedef void (*flush_pages_fn)(const uint32_t *va, int count);
+
+/**
+ * Routines with more than one implementation, pointed at the best one for the
+ * CPU we're running on. Safe to call before init_cpu_ops(); they start out
+ * pointed at versions that work on any 386.
+ */
+struct cpu_ops {
+    memcpy_fn memcpy;           // copy a block of memory
+    memset_fn memset;           // fill a block of memory
+    zero_page_fn zero_page;     // zero a page-aligned 4K page
+    flush_pages_fn flush_pages; // drop pages from the TLB
+};
+
+extern struct cpu_ops g_cpu_ops;
+
+enum cpu_op {
+    CPU_OP_MEMCPY,
+    CPU_OP_MEMSET,
+    CPU_OP_ZERO_PAGE,
+    CPU_OP_FLUSH_PAGES,
+    NR_CPU_OPS
+};
+
+/**
+ * One implementation of a CPU op.
+ */
+struct cpu_impl {
+    const char *name;           // printed at boot
+    uint32_t features;          // CPU_FEAT_* bits required
+    void *fn;                   // one of the *_fn types above
+};
+
+// detect CPU features and select the best usable implementation of each op
+void init_cpu_ops(void);
+
+// get the CPU_FEAT_* bits detected by init_cpu_ops()
+uint32_t get_cpu_features(void);
+
+// get the implementations of an op, ordered from slowest to fastest; for
+//  benchmarks
+const struct cpu_impl * get_cpu_impls(enum cpu_op op, int *count);
+
+// check whether an implementation can run on this CPU
+bool cpu_impl_usable(const struct cpu_impl *impl);
+
+// get the name of an op, or of the implementation selected for it
+const char * get_cpu_op_name(enum cpu_op op);
+const char * get_cpu_impl_name(enum cpu_op op);
+
+#endif // __DISPATCH_H
@@ -595,8 +595,20 @@ __asm__ volatile (                              \
     :"a"(fn)                                    \
 )
 
+#define __cpuid_count(fn,sub,eax,ebx,ecx,edx)   \
+__asm__ volatile (                              \
+    "cpuid"                                     \
+    : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)\
+    :"a"(fn), "c"(sub)                          \
+)
+
 #define __cli() __asm__ volatile ("cli")
 #define __sti() __asm__ volatile ("sti")
+#define __hlt() __asm__ volatile ("hlt")
+
+// enable interrupts and halt; STI holds off interrupts until after the next
+// instruction, so an interrupt can't sneak in before the HLT and get missed
+#define __sti_hlt() __asm__ volatile ("sti; hlt" ::: "memory")
 
 #define __int3()  __asm__ volatile ("int3")
 
@@ -651,6 +663,10 @@ __asm__ volatile (                          \
     ::: "eax"                               \
 );
 
+#define flush_tlb_page(va) __asm__ volatile ("invlpg (%0)" :: "r"(va) : "memory")
+
+#define rdtsc(tsc) __asm__ volatile ("rdtsc" : "=A"(tsc))
+
 /**
  * Page Directory Entry for 32-bit Paging
  *
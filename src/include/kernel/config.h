@@ -34,6 +34,11 @@
 
 // memory
 #define MEMORY_REQUIRED         (1536 * KB)
+#define MAX_LOWMEM              (896 * MB)  // max physical memory mapped into kernel space
+#define NR_ZERO_PAGES           32          // pre-zeroed pages kept for ALLOC_ZERO
+#define ZERO_REFILL_BUDGET      2           // pages zeroed into the reserve per idle halt or free
+#define HOT_CACHE_HIGH          32          // max blocks per hot cache before draining
+#define HOT_CACHE_BATCH         8           // blocks moved per hot cache refill/drain
 #define HIGHER_GROUND           1   // map kernel in high virtual address space
 
 // terminal
@@ -49,12 +54,17 @@
 #define PRINT_LOGO              0   // show a special logo at boot
 #define PRINT_PAGE_MAP          0   // show initial page table mappings
 #define PRINT_IOCTL             1   // show ioctl calls
+#define PRINT_PAGE_ALLOC        0   // show every page allocation and free
 #define E9_HACK                 1   // tee console output to I/O port 0xE9
 #define EARLY_PRINT             1   // register default console when first char is printed
 
 // kernel log
 #define KERNEL_LOG_SIZE         (2*PAGE_SIZE)
 
+// tracing
+#define TRACING                 1   // record tracepoints from boot (see tools/tracedump)
+#define NR_TRACE_RECORDS        1024    // trace ring buffer length; must be a power of 2
+
 // debugging
 #define SERIAL_DEBUGGING        0   // enable debugging over COM port
 #define SERIAL_DEBUG_PORT       COM1_PORT
@@ -79,10 +89,7 @@
 #define MAX_NR_POOLS            32    // max num concurrent pools
 
 // filesystem
-#define MAX_NR_INODES           64    // max num inodes
-#define MAX_NR_DENTRIES         64    // max num directory entries
 #define MAX_NR_TOTAL_OPEN       64    // max num open files on system
-#define MAX_NR_IO_RANGES        32    // max num I/O range reservations
 
 // i/o
 #define NR_TERMINAL             7     // number of virtual terminals
@@ -34,6 +34,7 @@ struct console {
     void (*setup)(struct console *);
     int (*write)(struct console *, const char *, size_t);
     int (*getc)(struct console *);
+    void (*sync)(struct console *);     // flush, then write synchronously
 
     struct console *next;
 };
@@ -49,4 +50,8 @@ int console_write(const char *buf, size_t count);
 // wait for a character to be received by the default console
 int console_getc(void);
 
+// flush all consoles and have them write synchronously from now on; for
+//  panics and crashes, when interrupts can't be relied on
+void console_sync(void);
+
 #endif // __CONSOLE_H
@@ -40,6 +40,7 @@
 #define TIOCMSET            _IOCTL_W(_IOC_TTY,0x04,const int)                   // Set modem control bits
 #define TIOCGICOUNT         _IOCTL_W(_IOC_TTY,0x05,struct serial_stats)         // Get serial line interrupt counts
 #define TIOCSTI             _IOCTL_R(_IOC_TTY,0x06,const char)                  // Put char into input buffer
+#define TIOCGSERIAL         _IOCTL_R(_IOC_TTY,0x07,struct serial_info)          // Get serial port info
 
 //
 // RTC IOCTL functions
@@ -66,6 +66,32 @@ void irq_setmask(uint16_t mask);
 void irq_register(int irq, irq_handler func);
 void irq_unregister(int irq, irq_handler func);
 
+// print interrupt statistics, incl. the longest time each ISR ran with
+//  interrupts disabled
+void print_irq_stats(void);
+
+//
+// Bottom Halves
+//
+// An ISR runs with interrupts disabled, so it should only grab what it needs
+// from the hardware and call mark_bh() to have the rest of the work done in a
+// bottom half. Pending bottom halves run with interrupts enabled once the
+// outermost ISR is done, before returning to the interrupted code; so either
+// right before returning to user mode or when the idle loop wakes up. A
+// bottom half never runs nested within itself or another bottom half.
+//
+#define BH_KEYBOARD     0       // PS/2 keyboard scancode translation
+#define BH_TTY          1       // TTY flip buffer processing
+#define NR_BH           2
+
+typedef void (*bh_handler)(void);
+
+// install the handler for a bottom half
+void init_bh(int nr, bh_handler func);
+
+// schedule a bottom half to run; safe to call from an ISR
+void mark_bh(int nr);
+
 #endif // __ASSEMBLER__
 
 #endif // __IRQ_H
@@ -0,0 +1,59 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: include/kernel/kmalloc.h
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * =============================================================================
+ */
+
+#ifndef __KMALLOC_H
+#define __KMALLOC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#define KMALLOC_MIN_SIZE    8       // smallest size class
+#define KMALLOC_MAX_SIZE    1024    // largest size class; bigger goes to alloc_pages
+
+/**
+ * Allocation statistics for a kmalloc size class.
+ */
+struct kmalloc_stats {
+    size_t size;            // object size; 0 for page-backed allocations
+    size_t nr_pages;        // pages currently held by this class
+    size_t nr_active;       // objects currently allocated
+    size_t nr_total;        // object slots in the pages held (slab classes only)
+    size_t nr_allocs;       // lifetime number of allocations
+    size_t nr_frees;        // lifetime number of frees
+    size_t bytes_requested; // lifetime bytes requested by callers
+    size_t bytes_allocated; // lifetime bytes handed out to callers
+};
+
+// allocate 'size' bytes of kernel memory; flags are the same as alloc_pages;
+//  small sizes come from per-class pools, large sizes from alloc_pages
+void * kmalloc(size_t size, int flags);
+
+// free memory given out by kmalloc
+void kfree(const void *ptr);
+
+// get the statistics for a size class; the last index is the page-backed
+//  class, returns false if the index is out of range
+bool get_kmalloc_stats(int index, struct kmalloc_stats *stats);
+
+// print per-class statistics to the console
+void print_kmalloc_stats(void);
+
+#endif // __KMALLOC_H
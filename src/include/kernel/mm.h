@@ -26,11 +26,12 @@
 
 #define MAX_ORDER           8   // max alloc: 1M (w/ 4k pages)
 #define MAX_ORDER_SIZE      (1 << (MAX_ORDER+PAGE_SHIFT))
+#define NR_HOT_ORDERS       2   // orders 0 and 1 are cached per-order
 
 enum zone_type {
     ZONE_DMA,           // 4k - 640k
-    ZONE_NORMAL,        // 1M - 4M
-    ZONE_HIGHMEM,       // 4M - 4G
+    ZONE_NORMAL,        // 1M - MAX_LOWMEM
+    ZONE_HIGHMEM,       // MAX_LOWMEM - 4G
     NR_ZONES
 };
 
@@ -42,21 +43,95 @@ enum zone_type {
 // check whether reading or writing a virtual address would cause a page fault
 bool virt_addr_valid(void *va);
 
-// walk the page table and return the PTE pointed to by the virtual address
+// walk the page table and return the PTE pointed to by the virtual address;
+//  for an address in a large page, this is the PDE
 bool walk_page_table(uint32_t va, pte_t **pte);
 
+// enable 4M pages if the CPU supports them; returns false if not supported
+bool enable_large_pages(void);
+
 // update a range of contiguous page mappings with the specified attributes,
-//   flags set to 0 will clear the mapping
+//   flags set to 0 will clear the mapping; page tables are allocated as needed,
+//   add _PAGE_LARGE to use 4M pages for any aligned 4M chunks in the range
 void update_page_mappings(uint32_t va, uint32_t pa, size_t count, pgflags_t flags);
 
+// a set of page mapping changes whose TLB invalidation is deferred until
+//  commit; past MAP_BATCH_SIZE pages, commit flushes the whole TLB instead of
+//  invalidating page by page
+#define MAP_BATCH_SIZE      32
+
+struct map_batch {
+    uint32_t va[MAP_BATCH_SIZE];    // pages to invalidate
+    int count;                      // number of pages to invalidate
+    bool flush_all;                 // flush the whole TLB on commit
+};
+
+// start a new batch of mapping changes
+void map_batch_init(struct map_batch *batch);
+
+// map (or unmap, if flags are 0) a single 4K page as part of a batch
+void map_batch_add(struct map_batch *batch, uint32_t va, uint32_t pa, pgflags_t flags);
+
+// invalidate the TLB entries for all pages changed in the batch
+void map_batch_commit(struct map_batch *batch);
+
+// allocate a zeroed page for use as a page table; before the page allocator is
+//  up, these come from a small reserve set aside by init_zones
+void * alloc_pgtbl(void);
+
 // allocate physical page frames;
-//  uses a buddy allocator
+//  uses a buddy allocator with per-order free lists
 void * alloc_pages(int flags, int order);
 
 // free pages given out by alloc_pages;
 //  order must match or you will cause havoc!
 void free_pages(void *addr, int order);
 
+/**
+ * Zeroed page reserve statistics. Single-page ALLOC_ZERO requests are served
+ * from a reserve of pages that were zeroed ahead of time; anything else that
+ * needs zeroing is zeroed on the spot.
+ */
+struct zero_page_stats {
+    size_t nr_reserved;     // zeroed pages currently in the reserve
+    size_t nr_hits;         // ALLOC_ZERO pages served from the reserve
+    size_t nr_misses;       // ALLOC_ZERO pages zeroed at allocation time
+    size_t nr_refilled;     // pages zeroed into the reserve
+};
+
+// zero up to 'budget' free pages into the reserve; called from idle_work()
+//  when there's nothing better to do, returns the number of pages zeroed
+int refill_zero_pages(int budget);
+
+// get the zeroed page reserve statistics
+void get_zero_page_stats(struct zero_page_stats *stats);
+
+/**
+ * Hot cache statistics. Recently freed blocks of the smallest orders are kept
+ * off the buddy free lists and handed back out most-recent-first; the caches
+ * are refilled from and drained back to the free lists in batches.
+ */
+struct hot_cache_stats {
+    size_t nr_cached[NR_HOT_ORDERS];    // blocks currently cached, per order
+    size_t nr_hits;                     // allocations served from a cache
+    size_t nr_refills;                  // batches taken from the free lists
+    size_t nr_drains;                   // batches given back to the free lists
+};
+
+// get the hot cache statistics
+void get_hot_cache_stats(struct hot_cache_stats *stats);
+
+// print page allocator statistics to the console
+void print_mm_stats(void);
+
+// get the order of a block given out by alloc_pages;
+//  returns -1 if the address is not page-aligned or outside the allocator
+int get_block_order(void *addr);
+
+// check the free lists, hot caches and zeroed page reserve against the buddy
+//  bitmaps; returns the total number of free pages, or -1 on a mismatch
+int verify_free_lists(void);
+
 // calculate the order required to allocate a number of pages
 int get_order(size_t size);
 
@@ -29,26 +29,35 @@
 #define POOL_MAGIC      'lwep'
 #define INVALID_POOL    ((pool_t *) NULL)
 #define POOL_MAX_NAME   16
+#define POOL_MIN_ITEMS  2   // min number of items per slab
+
 /**
  * Memory pool for allocating items of a fixed size.
+ *
+ * Items are carved out of page-backed slabs. Each slab starts with a small
+ * header; free items hold a link to the next free item in the same slab, so
+ * there is no per-item overhead. The pool grows by one slab at a time when all
+ * slabs are full and gives a slab back to the page allocator as soon as all of
+ * its items are freed.
  */
 struct pool {
     uint32_t magic;     // identifier for pool type
     const char *name;   // pool name
     size_t size;        // item size bytes
-    size_t capacity;    // max number of item slots
+    size_t capacity;    // number of item slots in all slabs
     size_t count;       // number of slots allocated
+    size_t nr_slabs;    // number of slabs held
     list_t list;        // list of pools on system
-    list_t free_list;   // free slots
-    int order;          // allocation order
-    void *alloc;        // item allocation
+    list_t partial;     // slabs with at least one free slot
+    list_t full;        // slabs with no free slots
+    int order;          // slab allocation order
+    int per_slab;       // number of item slots per slab
 };
 typedef struct pool pool_t;
 
 // pool_t *find_pool(const char *name);
 
-// TODO: remove max capacity
-pool_t * pool_create(const char *name, size_t capacity, size_t size, int flags);
+pool_t * pool_create(const char *name, size_t size, int flags);
 
 void pool_destroy(pool_t *pool);
 
@@ -56,4 +65,8 @@ void * pool_alloc(pool_t *pool, int flags);
 
 void pool_free(pool_t *pool, const void *item);
 
+// get the pool an item was allocated from, or INVALID_POOL if the address does
+//  not belong to any pool
+pool_t * pool_of(const void *item);
+
 #endif // __POOL_H
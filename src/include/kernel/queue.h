@@ -24,9 +24,11 @@
 #ifndef __QUEUE_H
 #define __QUEUE_H
 
+#include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 struct ring {
     char *ring;         // character queue ring buffer pointer
@@ -34,9 +36,13 @@ struct ring {
     size_t count;       // number of characters in the queue
     uint32_t head;      // head pointer
     uint32_t tail;      // tail pointer
+    uint32_t mask;      // length - 1 if length is a power of 2, otherwise 0
 };
 
-#define RING_INITIALIZER(buf)   { .ring = buf, .length = sizeof(buf) }
+#define _ring_mask(len)         ((((len) & ((len) - 1)) == 0) ? (len) - 1 : 0)
+
+#define RING_INITIALIZER(buf)                                                   \
+    { .ring = buf, .length = sizeof(buf), .mask = _ring_mask(sizeof(buf)) }
 // TODO: get ring of ring_init()
 
 /**
@@ -129,6 +135,271 @@ size_t ring_length(struct ring *q);
  */
 size_t ring_count(struct ring *q);
 
+/**
+ * Get the number of characters that can be added before the queue is full.
+ *
+ * @param q     a pointer to the ring
+ * @return      the free space in the queue
+ */
+size_t ring_space(struct ring *q);
+
 void ring_clear(struct ring *q);
 
+/**
+ * Push up to 'n' characters into the back of the queue.
+ *
+ * @param q     a pointer to the ring to push to
+ * @param buf   the characters to put into the queue
+ * @param n     the number of characters to put into the queue
+ * @return      the number of characters added; less than 'n' if the queue
+ *              filled up
+ */
+size_t ring_write(struct ring *q, const char *buf, size_t n);
+
+/**
+ * Pop up to 'n' characters from the front of the queue.
+ *
+ * @param q     a pointer to the ring to pop from
+ * @param buf   a buffer to receive the characters
+ * @param n     the maximum number of characters to pop
+ * @return      the number of characters popped
+ */
+size_t ring_read(struct ring *q, char *buf, size_t n);
+
+/**
+ * Copy up to 'n' characters from the front of the queue without popping them.
+ *
+ * @param q     a pointer to the ring to read from
+ * @param buf   a buffer to receive the characters
+ * @param n     the maximum number of characters to copy
+ * @return      the number of characters copied
+ */
+size_t ring_peek(const struct ring *q, char *buf, size_t n);
+
+/**
+ * Get the contiguous run of characters at the front of the queue, for
+ * consuming them in place (e.g. straight into a UART FIFO). The run stops at
+ * the end of the underlying buffer, so a second call may be needed after
+ * ring_skip() to get the rest. Pair with ring_skip().
+ *
+ * @param q     a pointer to the ring
+ * @param ptr   receives a pointer to the first character
+ * @return      the number of characters in the run
+ */
+size_t ring_read_region(const struct ring *q, const char **ptr);
+
+/**
+ * Pop 'n' characters from the front of the queue without copying them.
+ *
+ * @param q     a pointer to the ring
+ * @param n     the number of characters to drop; clamped to the queue count
+ */
+void ring_skip(struct ring *q, size_t n);
+
+/**
+ * Get the contiguous run of free space at the back of the queue, for filling
+ * it in place. The run stops at the end of the underlying buffer. Pair with
+ * ring_commit().
+ *
+ * @param q     a pointer to the ring
+ * @param ptr   receives a pointer to the first free slot
+ * @return      the number of free slots in the run
+ */
+size_t ring_write_region(const struct ring *q, char **ptr);
+
+/**
+ * Push 'n' characters that were written in place into the back of the queue.
+ *
+ * @param q     a pointer to the ring
+ * @param n     the number of characters to add; clamped to the free space
+ */
+void ring_commit(struct ring *q, size_t n);
+
+/**
+ * Single-producer, single-consumer character queue. The producer (e.g. an
+ * interrupt handler) only ever writes 'tail' and the consumer (e.g. a task
+ * reading a device) only ever writes 'head', so the two can run concurrently
+ * without disabling interrupts. The indices run freely and are masked on
+ * access, so the length must be a power of 2.
+ *
+ * Only one context may produce and only one may consume at a time.
+ */
+struct spsc_ring {
+    char *ring;                 // character queue ring buffer pointer
+    uint32_t mask;              // buffer length - 1
+    volatile uint32_t head;     // next char to read; written by the consumer
+    volatile uint32_t tail;     // next free slot; written by the producer
+};
+
+#define SPSC_RING_INITIALIZER(buf)  { .ring = buf, .mask = sizeof(buf) - 1 }
+
+/**
+ * Initialize the queue using the specified buffer.
+ *
+ * @param q     a pointer to the queue to initialize
+ * @param buf   a pre-allocated character buffer
+ * @param len   the size of the character buffer; must be a power of 2
+ */
+void spsc_init(struct spsc_ring *q, char *buf, size_t len);
+
+// get the number of characters in the queue; from either side
+size_t spsc_count(const struct spsc_ring *q);
+
+// get the free space in the queue; from either side
+size_t spsc_space(const struct spsc_ring *q);
+
+/**
+ * Producer: push a character into the back of the queue.
+ *
+ * @return      `true` if the character was added (queue not full)
+ */
+bool spsc_put(struct spsc_ring *q, char c);
+
+/**
+ * Producer: push up to 'n' characters into the back of the queue.
+ *
+ * @return      the number of characters added
+ */
+size_t spsc_write(struct spsc_ring *q, const char *buf, size_t n);
+
+/**
+ * Consumer: pop a character from the front of the queue.
+ *
+ * @param c     receives the popped character
+ * @return      `true` if a character was popped (queue not empty)
+ */
+bool spsc_get(struct spsc_ring *q, char *c);
+
+/**
+ * Consumer: pop up to 'n' characters from the front of the queue.
+ *
+ * @return      the number of characters popped
+ */
+size_t spsc_read(struct spsc_ring *q, char *buf, size_t n);
+
+/**
+ * Consumer: discard everything currently in the queue.
+ */
+void spsc_clear(struct spsc_ring *q);
+
+/**
+ * Declare a fixed-length queue of 'type' elements named 'struct name', along
+ * with a set of static inline functions prefixed with 'name_' that operate on
+ * it. Everything is specialized at compile time, so elements are copied by
+ * assignment (or memcpy for bulk ops) with no per-element function calls.
+ * The indices run freely and are masked on access, so 'len' must be a power
+ * of 2.
+ *
+ * The generated queue does no locking; the caller is responsible for keeping
+ * producers and consumers apart.
+ *
+ *   name_init(q)           empty the queue
+ *   name_count(q)          number of elements in the queue
+ *   name_space(q)          number of elements that can be added
+ *   name_empty(q)          `true` if the queue is empty
+ *   name_full(q)           `true` if the queue is full
+ *   name_put(q, item)      push an element; `false` if the queue is full
+ *   name_get(q, &item)     pop an element; `false` if the queue is empty
+ *   name_peek(q)           pointer to the front element, or NULL if empty
+ *   name_write(q, buf, n)  push up to 'n' elements; returns the number pushed
+ *   name_read(q, buf, n)   pop up to 'n' elements; returns the number popped
+ */
+#define DECLARE_RING(name, type, len)                                           \
+static_assert((len) > 0 && ((len) & ((len) - 1)) == 0,                          \
+    #name ": length must be a power of 2");                                     \
+                                                                                \
+struct name {                                                                   \
+    type buf[len];                                                              \
+    uint32_t head;                                                              \
+    uint32_t tail;                                                              \
+};                                                                              \
+                                                                                \
+static inline void name##_init(struct name *q)                                  \
+{                                                                               \
+    q->head = q->tail = 0;                                                      \
+}                                                                               \
+                                                                                \
+static inline size_t name##_count(const struct name *q)                         \
+{                                                                               \
+    return q->tail - q->head;                                                   \
+}                                                                               \
+                                                                                \
+static inline size_t name##_space(const struct name *q)                         \
+{                                                                               \
+    return (len) - (q->tail - q->head);                                         \
+}                                                                               \
+                                                                                \
+static inline bool name##_empty(const struct name *q)                           \
+{                                                                               \
+    return q->tail == q->head;                                                  \
+}                                                                               \
+                                                                                \
+static inline bool name##_full(const struct name *q)                            \
+{                                                                               \
+    return q->tail - q->head == (len);                                          \
+}                                                                               \
+                                                                                \
+static inline bool name##_put(struct name *q, type item)                        \
+{                                                                               \
+    if (name##_full(q)) {                                                       \
+        return false;                                                           \
+    }                                                                           \
+    q->buf[q->tail++ & ((len) - 1)] = item;                                     \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+static inline bool name##_get(struct name *q, type *item)                       \
+{                                                                               \
+    if (name##_empty(q)) {                                                      \
+        return false;                                                           \
+    }                                                                           \
+    *item = q->buf[q->head++ & ((len) - 1)];                                    \
+    return true;                                                                \
+}                                                                               \
+                                                                                \
+static inline type * name##_peek(struct name *q)                                \
+{                                                                               \
+    if (name##_empty(q)) {                                                      \
+        return NULL;                                                            \
+    }                                                                           \
+    return &q->buf[q->head & ((len) - 1)];                                      \
+}                                                                               \
+                                                                                \
+static inline size_t name##_write(struct name *q,                               \
+    const type *buf, size_t n)                                                  \
+{                                                                               \
+    uint32_t pos = q->tail & ((len) - 1);                                       \
+    size_t first;                                                               \
+                                                                                \
+    if (n > name##_space(q)) {                                                  \
+        n = name##_space(q);                                                    \
+    }                                                                           \
+    first = (len) - pos;                                                        \
+    if (first > n) {                                                            \
+        first = n;                                                              \
+    }                                                                           \
+    memcpy(&q->buf[pos], buf, first * sizeof(type));                            \
+    memcpy(&q->buf[0], buf + first, (n - first) * sizeof(type));                \
+    q->tail += n;                                                               \
+    return n;                                                                   \
+}                                                                               \
+                                                                                \
+static inline size_t name##_read(struct name *q, type *buf, size_t n)           \
+{                                                                               \
+    uint32_t pos = q->head & ((len) - 1);                                       \
+    size_t first;                                                               \
+                                                                                \
+    if (n > name##_count(q)) {                                                  \
+        n = name##_count(q);                                                    \
+    }                                                                           \
+    first = (len) - pos;                                                        \
+    if (first > n) {                                                            \
+        first = n;                                                              \
+    }                                                                           \
+    memcpy(buf, &q->buf[pos], first * sizeof(type));                            \
+    memcpy(buf + first, &q->buf[0], (n - first) * sizeof(type));                \
+    q->head += n;                                                               \
+    return n;                                                                   \
+}
+
 #endif  // __QUEUE_H
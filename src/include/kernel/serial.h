@@ -136,11 +136,14 @@ enum priority {
 #define UART_FCR_RESET_RCVR 0x02    // Receiver FIFO Reset
 #define UART_FCR_RESET_XMIT 0x04    // Transmitter FIFO Reset
 #define UART_FCR_DMA        0x08    // DMA Mode Select
+#define UART_FCR_FIFO64     0x20    // 64-Byte FIFO Enable (16750 only; DLAB=1)
 #define UART_FCR_RCVR_TRIG  0xC0    // Receiver Interrupt Trigger
 
 //
 // Receiver Interrupt Trigger Levels
 //
+// A 16750 in 64-byte FIFO mode triggers at 1, 16, 32, and 56 bytes instead.
+//
 enum recv_trig {
     RCVR_TRIG_1,                    // Interrupt when 1 byte received
     RCVR_TRIG_4,                    // Interrupt when 4 bytes received
@@ -236,6 +239,30 @@ enum parity {
 
 #define UART_MSR_ANY_DELTA  0x0F    // mask for delta bits
 
+//
+// UART Types
+//
+enum uart_type {
+    UART_UNKNOWN,                   // exists, but unrecognized; treated like a 16450
+    UART_8250,                      // no FIFOs, no scratch register
+    UART_16450,                     // no FIFOs
+    UART_16550,                     // broken FIFOs, not used
+    UART_16550A,                    // 16-byte FIFOs
+    UART_16750,                     // 64-byte FIFOs
+    NR_UART_TYPES
+};
+
+//
+// Serial Port Info
+//
+struct serial_info {
+    int type;                   // UART type; see uart_type enum
+    int port;                   // I/O base port number
+    int baud_divisor;           // baud rate divisor
+    int fifo_size;              // FIFO depth in use, 1 if FIFOs are off
+    int rx_trig;                // current receive trigger level, in bytes
+};
+
 //
 // Line and Modem Statistics
 //
@@ -246,6 +273,10 @@ struct serial_stats {
     uint32_t n_timeout;         // timeout error count
     uint32_t n_break;           // break interrupt count
     uint32_t n_tx, n_rx;        // chars transmitted/received count
+    uint32_t n_rx_dropped;      // chars dropped, flip buffer full
+    uint32_t n_rx_max;          // most chars received in one interrupt
+    uint32_t n_intr;            // interrupts serviced
+    uint32_t n_con_dropped;     // console chars dropped, console queue full
     uint32_t n_xchar;           // control chars transmitted
     uint32_t n_cts;             // clear-to-send count
     uint32_t n_dsr;             // data set ready count
@@ -301,7 +332,8 @@ struct fcr {
             uint8_t rx_reset    : 1;    // Clear receiver FIFO
             uint8_t tx_reset    : 1;    // Clear transmitter FIFO
             uint8_t dma         : 1;    // Enable DMA mode
-            uint8_t             : 2;    // (reserved)
+            uint8_t             : 1;    // (reserved)
+            uint8_t fifo64      : 1;    // Enable 64-byte FIFOs (16750 only)
             uint8_t trig        : 2;    // FIFO depth; see recv_trig enum
         };
         uint8_t _value;
@@ -409,6 +441,7 @@ struct com {
     bool valid      : 1;        // port exists and is usable
     bool open       : 1;        // port is currently in use
     bool reserved   : 1;        // port exists, but is reserved by another driver
+    bool console    : 1;        // port is the serial console
 
     // buffers
     struct ring tx_ring;        // output queue
@@ -424,6 +457,12 @@ struct com {
     struct msr msr;             // modem status register
     uint16_t baud_divisor;      // baud rate divisor
 
+    // FIFO state
+    enum uart_type type;        // detected UART type
+    int fifo_size;              // FIFO depth in use, 1 if FIFOs are off
+    enum recv_trig rx_trig;     // current receive trigger level
+    int rx_trig_votes;          // >0 to raise rx_trig, <0 to lower it
+
     // statistics
     struct serial_stats stats;
 };
@@ -26,6 +26,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <kernel/config.h>
+#include <kernel/input.h>
 #include <kernel/queue.h>
 #include <kernel/tty.h>
 #include <kernel/vga.h>
@@ -135,6 +136,9 @@ void * get_vga_fb(void);
 // wait for a character keypress (NOTE: BLOCKS!!)
 int kb_getc(void);
 
+// pop the oldest buffered key event; `false` if there are none
+bool kb_read_event(struct key_event *evt);
+
 // save/restore terminal state
 void terminal_save(struct terminal *term, struct terminal_save_state *save);
 void terminal_restore(struct terminal *term, struct terminal_save_state *save);
@@ -28,7 +28,16 @@ typedef unsigned char   cc_t;
 #define N_TTY           0           // TTY line discipline
 #define NR_LDISC        1           // num ldiscs
 
-#define NCCS            0           // num control characters (TODO)
+// c_cc: control characters
+#define VEOF            0           // end of file (^D)
+#define VERASE          1           // erase a char (DEL)
+#define VKILL           2           // erase the line (^U)
+#define VWERASE         3           // erase a word (^W)
+#define VSTART          4           // resume output (^Q)
+#define VSTOP           5           // suspend output (^S)
+#define NCCS            6           // num control characters
+
+#define _POSIX_VDISABLE 0           // disables a control character
 
 struct termios {
     tcflag_t c_line;                // ldisc number
@@ -45,6 +54,8 @@ struct termios {
 #define IGNCR           (1 << 2)    // ignore carriage return
 #define IXON            (1 << 3)    // enable software flow control on input
 #define IXOFF           (1 << 4)    // enable software flow control on output
+#define IGNBRK          (1 << 5)    // ignore break condition
+#define IGNPAR          (1 << 6)    // ignore chars with framing or parity errors
 
 // c_oflag: output modes
 #define OPOST           (1 << 0)    // enable post processing
@@ -57,6 +68,9 @@ struct termios {
 // c_lflag: local modes
 #define ECHO            (1 << 0)    // echo input characters
 #define ECHOCTL         (1 << 1)    // if ECHO set, echo control characters as ^C
+#define ICANON          (1 << 2)    // canonical mode; line editing, read by line
+#define ECHOE           (1 << 3)    // if ICANON and ECHO set, ERASE and friends
+                                    //   visually erase chars
 
 // serial modem control/status
 #define TIOCM_DTR       (1 << 0)    // ctl: DTR (data terminal ready)
@@ -0,0 +1,105 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: include/kernel/trace.h
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * =============================================================================
+ */
+
+#ifndef __TRACE_H
+#define __TRACE_H
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <kernel/config.h>
+
+#define TRACE_NR_ARGS       5
+
+/**
+ * A single trace event. Nothing is formatted in the kernel; the event id is
+ * the address of the tracepoint's format string, which tools/tracedump looks
+ * up in kernel.elf to turn the record back into text.
+ */
+struct trace_record {
+    uint64_t tsc;                   // time stamp counter, or sequence number if no TSC
+    uint32_t event;                 // address of the event format string
+    uint32_t args[TRACE_NR_ARGS];   // event arguments
+};
+static_assert(sizeof(struct trace_record) == 32, "sizeof(struct trace_record)");
+
+extern bool g_trace_on;
+
+void __trace(uint32_t event, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4);
+
+/**
+ * Record a trace event. Takes a printf-style format string literal and up to
+ * TRACE_NR_ARGS 32-bit arguments. The format is only ever read by the host
+ * decoder, which understands %d, %u, %x, %X, %c, %s (strings in kernel.elf),
+ * and %pS (symbol+offset). Costs a load and a branch while tracing is stopped,
+ * and nothing at all when TRACING is 0.
+ */
+#if TRACING
+#define trace(fmt, ...)                                                         \
+do {                                                                            \
+    _trace_check_nargs(__VA_ARGS__);                                            \
+    if (g_trace_on) {                                                           \
+        static const char __tracefmt[] = fmt;                                   \
+        _trace_args(__tracefmt, ##__VA_ARGS__, 0, 0, 0, 0, 0);                  \
+    }                                                                           \
+} while (0)
+#else
+#define trace(fmt, ...)                                                         \
+do {                                                                            \
+    _trace_check_nargs(__VA_ARGS__);                                            \
+    if (0) {                                                                    \
+        _trace_args(fmt, ##__VA_ARGS__, 0, 0, 0, 0, 0);                         \
+    }                                                                           \
+} while (0)
+#endif
+
+// extra arguments would be silently dropped, and tracedump would then decode
+// the record against a format asking for more than was recorded
+#define _trace_check_nargs(...)                                                 \
+    static_assert(_trace_nargs(__VA_ARGS__) <= TRACE_NR_ARGS,                   \
+        "too many trace() arguments")
+
+#define _trace_nargs(...)                                                       \
+    _trace_nth(_, ##__VA_ARGS__, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3,   \
+        2, 1, 0)
+#define _trace_nth(_,a1,a2,a3,a4,a5,a6,a7,a8,a9,a10,a11,a12,a13,a14,a15,n,...) n
+
+#define _trace_args(fmt,a0,a1,a2,a3,a4,...)                                     \
+    __trace((uint32_t) (fmt), (uint32_t) (a0), (uint32_t) (a1),                 \
+        (uint32_t) (a2), (uint32_t) (a3), (uint32_t) (a4))
+
+// start or stop recording events
+void trace_start(void);
+void trace_stop(void);
+
+// copy out up to 'count' of the oldest unread records and mark them read;
+//  returns the number of records copied
+size_t trace_read(struct trace_record *buf, size_t count);
+
+// get the number of records lost to the ring buffer wrapping before they
+//  were read
+size_t trace_dropped(void);
+
+// print the whole trace buffer to the console in hex, for tools/tracedump
+void trace_dump(void);
+
+#endif // __TRACE_H
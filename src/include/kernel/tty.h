@@ -28,6 +28,7 @@
 #ifndef __TTY_H
 #define __TTY_H
 
+#include <stdbool.h>
 #include <stddef.h>
 #include <unistd.h>
 #include <kernel/device.h>
@@ -38,6 +39,8 @@
 
 #define TTY_BUFFER_SIZE         1024
 #define TTY_THROTTLE_THRESH     128
+#define TTY_LINE_MAX            255     // longest line in canonical mode
+#define TTY_FLIPBUF_SIZE        256     // chars per flip buffer half
 
 // TTY device minor numbers
 #define TTY_MIN                 1
@@ -60,6 +63,8 @@
 #define I_IGNCR(tty)            _I_FLAG(tty, IGNCR)
 #define I_IXON(tty)             _I_FLAG(tty, IXON)
 #define I_IXOFF(tty)            _I_FLAG(tty, IXOFF)
+#define I_IGNBRK(tty)           _I_FLAG(tty, IGNBRK)
+#define I_IGNPAR(tty)           _I_FLAG(tty, IGNPAR)
 
 // termios output flag macros
 #define O_OPOST(tty)            _O_FLAG(tty, OPOST)
@@ -72,14 +77,43 @@
 // termios local flag macros
 #define L_ECHO(tty)             _L_FLAG(tty, ECHO)
 #define L_ECHOCTL(tty)          _L_FLAG(tty, ECHOCTL)
-
-#define STOP_CHAR(tty)          0x13    // TODO: tty->termios.c_cc[VSTOP]
-#define START_CHAR(tty)         0x11    // TODO: tty->termios.c_cc[VSTART]
+#define L_ICANON(tty)           _L_FLAG(tty, ICANON)
+#define L_ECHOE(tty)            _L_FLAG(tty, ECHOE)
+
+// termios control characters
+#define EOF_CHAR(tty)           ((tty)->termios.c_cc[VEOF])
+#define ERASE_CHAR(tty)         ((tty)->termios.c_cc[VERASE])
+#define KILL_CHAR(tty)          ((tty)->termios.c_cc[VKILL])
+#define WERASE_CHAR(tty)        ((tty)->termios.c_cc[VWERASE])
+#define START_CHAR(tty)         ((tty)->termios.c_cc[VSTART])
+#define STOP_CHAR(tty)          ((tty)->termios.c_cc[VSTOP])
+
+// received char flags
+#define TTY_NORMAL              0       // no error
+#define TTY_BREAK               1       // break condition; char is NUL
+#define TTY_FRAME               2       // framing error
+#define TTY_PARITY              3       // parity error
+#define TTY_OVERRUN             4       // chars were lost before this one; char is good
 
 // type shit
 struct tty;
 struct tty_ldisc;
 
+//
+// TTY Flip Buffer
+//
+// Received chars and their flags are collected in one half by the driver's
+// ISR, while the other half is handed to the line discipline in one batch by
+// the TTY bottom half. The halves switch places each time the bottom half
+// runs.
+//
+struct tty_flip_buffer {
+    char char_buf[2*TTY_FLIPBUF_SIZE];  // received chars
+    char flag_buf[2*TTY_FLIPBUF_SIZE];  // TTY_* flag for each received char
+    int buf_num;                        // half being filled by the ISR
+    int count;                          // num chars in the half being filled
+};
+
 //
 // TTY Driver
 //
@@ -124,6 +158,7 @@ struct tty {
     struct tty_ldisc *ldisc;        // line discipline
     struct tty_driver driver;       // low-level device driver
     struct termios termios;         // input/output behavior
+    struct tty_flip_buffer flip;    // received chars waiting for the ldisc
 
     // private per-instance data
     void *ldisc_data;
@@ -148,8 +183,9 @@ struct tty_ldisc {
     void    (*clear)(struct tty *);
     int     (*ioctl)(struct tty *, int op, void *arg);
 
-    // called from below (interrupt)
-    void    (*recv)(struct tty *, char *buf, size_t count);
+    // called from below (bottom half); flags may be NULL if all chars are
+    //  TTY_NORMAL
+    void    (*recv)(struct tty *, const char *buf, const char *flags, size_t count);
     size_t  (*recv_room)(struct tty *);
 };
 
@@ -162,4 +198,24 @@ int tty_putchar(struct tty *tty, char c);
 
 void tty_flush(struct tty *tty);
 
+// queue a received char for the ldisc; called with interrupts disabled,
+//  usually from the driver ISR, returns false if the flip buffer is full
+static inline bool tty_insert_flip_char(struct tty *tty, char c, char flag)
+{
+    struct tty_flip_buffer *flip = &tty->flip;
+    int i;
+
+    if (flip->count >= TTY_FLIPBUF_SIZE) {
+        return false;
+    }
+
+    i = flip->buf_num * TTY_FLIPBUF_SIZE + flip->count++;
+    flip->char_buf[i] = c;
+    flip->flag_buf[i] = flag;
+    return true;
+}
+
+// schedule the TTY bottom half to hand the flip buffer to the ldisc
+void tty_flip_buffer_push(struct tty *tty);
+
 #endif // __TTY_H
@@ -0,0 +1,98 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: include/kernel/wait.h
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * -----------------------------------------------------------------------------
+ * Wait queues. A reader that has nothing to do sleeps on a wait queue with
+ * wait_event() and the interrupt handler that makes progress calls wake_up().
+ * There is no scheduler yet, so sleeping means halting the CPU until an
+ * interrupt arrives instead of spinning.
+ * =============================================================================
+ */
+
+#ifndef __WAIT_H
+#define __WAIT_H
+
+#include <stdint.h>
+#include <i386/interrupt.h>
+#include <i386/x86.h>
+
+struct wait_queue {
+    volatile uint32_t wakeups;  // bumped by each wake_up()
+    volatile int nr_waiters;    // number of contexts sleeping on the queue
+};
+
+#define WAIT_QUEUE_INITIALIZER  { }
+
+void init_wait_queue(struct wait_queue *wq);
+
+/**
+ * Wake everything sleeping on a wait queue so it can re-check its condition.
+ * Safe to call from an interrupt handler.
+ *
+ * @param wq    a pointer to the wait queue
+ */
+void wake_up(struct wait_queue *wq);
+
+/**
+ * Sleep until 'cond' becomes true. The condition is checked with interrupts
+ * disabled and only re-checked after a wake_up() on the queue, so whatever
+ * makes it true must call wake_up() afterwards. Interrupts are enabled while
+ * sleeping; the caller's interrupt flag is restored on return.
+ *
+ * @param wq    a pointer to the wait queue
+ * @param cond  an expression to wait on
+ */
+#define wait_event(wq, cond)    __wait_event(wq, cond, (void) 0)
+
+/**
+ * Like wait_event(), but do a little deferred housekeeping with idle_work()
+ * each time before halting. Only for process context waits with nothing else
+ * to do, like a reader waiting on input; not for crash or interrupt paths.
+ *
+ * @param wq    a pointer to the wait queue
+ * @param cond  an expression to wait on
+ */
+#define wait_event_idle(wq, cond)   __wait_event(wq, cond, idle_work())
+
+// do a small, bounded amount of deferred work; called with interrupts disabled
+void idle_work(void);
+
+#define __wait_event(wq, cond, work)                                        \
+do {                                                                        \
+    struct wait_queue *__wq = (wq);                                         \
+    uint32_t __flags;                                                       \
+    uint32_t __seq;                                                         \
+                                                                            \
+    cli_save(__flags);                                                      \
+    __wq->nr_waiters++;                                                     \
+    for (;;) {                                                              \
+        __seq = __wq->wakeups;                                              \
+        if (cond) {                                                         \
+            break;                                                          \
+        }                                                                   \
+        while (__wq->wakeups == __seq) {                                    \
+            work;                                                           \
+            __sti_hlt();                                                    \
+            __cli();                                                        \
+        }                                                                   \
+    }                                                                       \
+    __wq->nr_waiters--;                                                     \
+    restore_flags(__flags);                                                 \
+} while (0)
+
+#endif // __WAIT_H
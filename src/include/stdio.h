@@ -53,6 +53,17 @@ int vprintf(const char *format, va_list args);
 int vsprintf(char *buffer, const char *format, va_list args);
 int vsnprintf(char *buffer, size_t bufsz, const char *format, va_list args);
 
+/**
+ * Output callback for vcbprintf. Receives the formatted output a run of
+ * characters at a time; no NUL terminator is passed. Returns the number of
+ * characters to count toward the vcbprintf return value, or a negative value
+ * to stop formatting and return it.
+ */
+typedef int (*printf_sink)(void *arg, const char *buf, size_t count);
+
+// printf through a callback, without an intermediate buffer (nonstandard)
+int vcbprintf(printf_sink sink, void *arg, const char *format, va_list args);
+
 void perror(const char *s);
 
 #endif // __STDIO_H
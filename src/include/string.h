@@ -42,6 +42,7 @@ void * memmove(void *dst, const void *src, size_t count);
 void * memset(void *dst, int c, size_t count);
 
 int memcmp(const void *lhs, const void *rhs, size_t count);
+void * memchr(const void *ptr, int c, size_t count);
 
 char * strcpy(char *restrict dst, const char *restrict src);
 char * stpcpy(char *restrict dst, const char *restrict src);                    // nonstandard
@@ -58,7 +59,7 @@ size_t strnlen(const char *str, size_t maxlen);
 int strcmp(const char *lhs, const char *rhs);
 int strncmp(const char *lhs, const char *rhs, size_t count);
 
-// char * strchr(const char *str, const char *substr);
+char * strchr(const char *str, int c);
 
 char * strerror(int errnum);
 
@@ -8,6 +8,7 @@ SOURCES := \
     fs.c \
     io.c \
     irq.c \
+    kmalloc.c \
     list.c \
     main.c \
     mm.c \
@@ -16,16 +17,25 @@ SOURCES := \
     ring.c \
     sys.c \
     task.c \
+    trace.c \
+    wait.c \
 
 ifeq "${TEST_BUILD}" "1"
 SOURCES += \
     test/test.c \
     test/test_bsf.c \
+    test/test_dispatch.c \
+    test/test_kmalloc.c \
     test/test_list.c \
+    test/test_mm.c \
+    test/test_pgtbl.c \
     test/test_pool.c \
     test/test_printf.c \
     test/test_ring.c \
     test/test_string.c \
+    test/test_trace.c \
+    test/test_tty.c \
+    test/test_wait.c \
 
 endif
 
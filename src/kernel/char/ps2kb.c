@@ -33,12 +33,17 @@
 #include <i386/boot.h>
 #include <i386/interrupt.h>
 #include <i386/io.h>
+#include <i386/paging.h>
 #include <i386/ps2.h>
 #include <i386/x86.h>
 #include <kernel/input.h>
 #include <kernel/irq.h>
+#include <kernel/kmalloc.h>
+#include <kernel/mm.h>
 #include <kernel/ohwes.h>
+#include <kernel/queue.h>
 #include <kernel/terminal.h>
+#include <kernel/trace.h>
 
 #define CHATTY_KB       1       // print extra debug messages
 #define PRINT_EVENTS    0       // print key events
@@ -49,6 +54,14 @@
 #define RETRY_COUNT     3       // command resends before giving up
 #define WARN_INTERVAL   10      // warn every N times a stray packet shows up
 
+#define KB_BUFFER_SIZE  64      // key events kept for readers
+#define KB_CHARQ_SIZE   8       // chars produced by one key, sent as a batch
+#define KB_SCANQ_SIZE   64      // scancodes waiting for the bottom half
+
+DECLARE_RING(kb_eventq, struct key_event, KB_BUFFER_SIZE);
+DECLARE_RING(kb_charq, char, KB_CHARQ_SIZE);
+DECLARE_RING(kb_scanq, uint8_t, KB_SCANQ_SIZE);
+
 struct kb {
     // keyboard configuration
     unsigned char ident[2];     // identifier word
@@ -75,14 +88,16 @@ struct kb {
     char altchar;
     char pollchar;
 
-    // // key event buffer
-    // struct ring eventq;            // TODO: make queue w/ generic type
-    // struct key_event ebuf[KB_BUFFER_SIZE];
+    // input queues
+    struct kb_eventq eventq;    // recent key events, oldest dropped first
+    struct kb_charq charq;      // chars waiting to go to the TTY
+    struct kb_scanq scanq;      // raw scancodes from the ISR
 
     // spurious scancode tracking
     int ack_count;
     int resend_count;
     int error_count;
+    int overrun_count;          // scancodes dropped, scanq full
 };
 
 static struct kb _kb = { };
@@ -107,7 +122,10 @@ void hard_reset(void);
 
 static void update_leds(void);
 static void kb_interrupt(int irq, struct iregs *regs);
+static void kb_bottom_half(void);
+static void kb_scancode(uint8_t scancode);
 static void kb_putq(char c);
+static void kb_flushq(void);
 
 static bool kb_ident(void);
 static bool kb_scset(uint8_t set);
@@ -132,6 +150,9 @@ void init_kb(void)
     init_ps2();
 
     g_kb->numlk = 1;
+    kb_eventq_init(&g_kb->eventq);
+    kb_charq_init(&g_kb->charq);
+    kb_scanq_init(&g_kb->scanq);
 
     // disable keyboard
     ps2_flush();
@@ -178,6 +199,7 @@ void init_kb(void)
     update_leds();
 
     // register ISR and unmask IRQ1 on the PIC
+    init_bh(BH_KEYBOARD, kb_bottom_half);
     irq_register(IRQ_KEYBOARD, kb_interrupt);
     irq_unmask(IRQ_KEYBOARD);
 
@@ -204,10 +226,14 @@ int kb_getc(void)
 
     cli_save(flags);
 
+    // translate scancodes here in case we were called from within a bottom
+    // half (e.g. the crash screen), where the keyboard's won't get to run
     g_kb->pollchar = 0;
-    __sti();
-    while (g_kb->pollchar == 0) { }     // TODO: poll timeout
-    __cli();
+    while (g_kb->pollchar == 0) {       // TODO: poll timeout
+        __sti_hlt();
+        __cli();
+        kb_bottom_half();
+    }
     c = g_kb->pollchar;
 
     restore_flags(flags);
@@ -215,8 +241,36 @@ int kb_getc(void)
     return c;
 }
 
+bool kb_read_event(struct key_event *evt)
+{
+    uint32_t flags;
+    bool ret;
+
+    cli_save(flags);
+    ret = kb_eventq_get(&g_kb->eventq, evt);
+    restore_flags(flags);
+
+    return ret;
+}
+
 static void kb_putq(char c)
 {
+    if (kb_charq_full(&g_kb->charq)) {
+        kb_flushq();
+    }
+    kb_charq_put(&g_kb->charq, c);
+    g_kb->pollchar = c;
+}
+
+static void kb_flushq(void)
+{
+    char buf[KB_CHARQ_SIZE];
+    size_t count;
+
+    if (kb_charq_empty(&g_kb->charq)) {
+        return;
+    }
+
     struct tty *tty = get_terminal(0)->tty;
     if (!tty || !tty->ldisc) {
         panic("no TTY attached to keyboard!");
@@ -225,8 +279,9 @@ static void kb_putq(char c)
         panic("keyboard has no input receiver!");
     }
 
-    tty->ldisc->recv(tty, &c, 1);
-    g_kb->pollchar = c;
+    // hand everything this key produced to the line discipline at once
+    count = kb_charq_read(&g_kb->charq, buf, sizeof(buf));
+    tty->ldisc->recv(tty, buf, NULL, count);
 }
 
 static void update_leds(void)
@@ -244,36 +299,23 @@ static void update_leds(void)
     }
 
     if (g_kb->leds != leds) {
+        // keep the ISR from eating the ACK
+        uint32_t flags;
+        cli_save(flags);
+        kb_disable();
         kb_setleds(leds);
+        kb_enable();
+        restore_flags(flags);
     }
 }
 
 static void kb_interrupt(int irq, struct iregs *regs)
 {
-    uint32_t flags;
     uint8_t status;
-    uint16_t sc;
-    uint16_t key;
-    bool release;
-    unsigned char c;
-    char *s;
-
-    struct key_event evt;
-    zeromem(&evt, sizeof(struct key_event));
-
-    c = '\0';
-    s = NULL;
+    uint8_t sc;
 
     assert(irq == IRQ_KEYBOARD);
 
-    //
-    // Scan Code to Key Code Mapping
-    // ----------------------------------------------------------------
-
-    // prevent keyboard from sending more interrupts
-    cli_save(flags);
-    kb_disable();
-
     // check keyboard status
     status = ps2_status();
 #if CHATTY_KB
@@ -286,8 +328,49 @@ static void kb_interrupt(int irq, struct iregs *regs)
 #endif
     (void) status;
 
-    // grab the scancode
+    // grab the scancode, translate it later with interrupts enabled
     sc = inb_delay(0x60);
+    if (!kb_scanq_put(&g_kb->scanq, sc)) {
+        g_kb->overrun_count++;
+    }
+    mark_bh(BH_KEYBOARD);
+}
+
+static void kb_bottom_half(void)
+{
+    uint32_t flags;
+    uint8_t sc;
+    bool more;
+
+    for (;;) {
+        cli_save(flags);
+        more = kb_scanq_get(&g_kb->scanq, &sc);
+        restore_flags(flags);
+        if (!more) {
+            break;
+        }
+        kb_scancode(sc);
+    }
+}
+
+static void kb_scancode(uint8_t scancode)
+{
+    uint16_t sc;
+    uint16_t key;
+    bool release;
+    unsigned char c;
+    char *s;
+
+    struct key_event evt;
+    zeromem(&evt, sizeof(struct key_event));
+
+    sc = scancode;
+    c = '\0';
+    s = NULL;
+
+    //
+    // Scan Code to Key Code Mapping
+    // ----------------------------------------------------------------
 
     // check for some unexpected scancodes
     switch (sc) {
@@ -559,7 +642,11 @@ record_key_event:
     evt.scancode = sc;
     evt.release = release;
     evt.c = c;
-    // TODO: add to event queue
+    if (kb_eventq_full(&g_kb->eventq)) {
+        struct key_event old;
+        kb_eventq_get(&g_kb->eventq, &old);
+    }
+    kb_eventq_put(&g_kb->eventq, evt);
 
 #if PRINT_EVENTS
     kprint("ps2kb: ");
@@ -572,9 +659,7 @@ record_key_event:
 #endif
 
 done:
-    // re-enable keyboard interrupts from controller
-    kb_enable();
-    restore_flags(flags);
+    kb_flushq();
 }
 
 static void sysrq(char c)
@@ -582,7 +667,7 @@ static void sysrq(char c)
     switch (c) {
         default:
             beep(ALERT_FREQ, ALERT_TIME, false);
-            kprint("\nsysrq: crash(c) debug-break(g) reboot(r)");
+            kprint("\nsysrq: crash(c) debug-break(g) irq(i) memory(m) reboot(r) trace(t)");
             break;
         case 'c':
             kb_enable();
@@ -592,9 +677,22 @@ static void sysrq(char c)
         case 'g':
             __int3();
             break;
+        case 'i':
+            kprint("\n");
+            print_irq_stats();
+            break;
+        case 'm':
+            kprint("\n");
+            print_mm_stats();
+            print_kmalloc_stats();
+            break;
         case 'r':
             hard_reset();
             break;
+        case 't':
+            kprint("\n");
+            trace_dump();
+            break;
     }
 }
 
@@ -31,6 +31,7 @@
 #include <kernel/ohwes.h>
 #include <kernel/rtc.h>
 #include <kernel/fs.h>
+#include <kernel/wait.h>
 
 // TODO: virtualize RTC so rates and interrupt types can be controlled per-process
 
@@ -128,6 +129,7 @@ struct rtc {
     uint64_t update_ticks;      // update ended
 };
 static struct rtc _rtc; // TODO: make per-process
+static struct wait_queue rtc_wait = WAIT_QUEUE_INITIALIZER;
 
 volatile struct rtc * get_rtc(void)
 {
@@ -220,6 +222,7 @@ static void rtc_interrupt(int irq, struct iregs *regs)
     }
 
     get_rtc()->int_count++;
+    wake_up(&rtc_wait);
 }
 
 static void set_mode(int mask)
@@ -519,11 +522,9 @@ int rtc_read(struct file *file, char *buf, size_t count)
     // get current interrupt count
     cli_save(flags);
     tick = get_rtc()->int_count;
-    __sti();
 
-    // spin until another interrupt happens
-    spin(tick == get_rtc()->int_count);
-    __cli();
+    // sleep until another interrupt happens
+    wait_event(&rtc_wait, tick != (uint32_t) get_rtc()->int_count);
 
     // capture new interrupt count
     tick = get_rtc()->int_count;
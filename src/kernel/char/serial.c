@@ -50,12 +50,14 @@
 #define PRINT_LINE_STATUS   0
 #define PRINT_MODEM_STATUS  0
 #define PRINT_TIMEOUT       0
+#define PRINT_RX_TRIG       0
 
 // counts of things
-#define FIFO_DEPTH          16          // hardware FIFO depth (assumed)
 #define RECV_MAX            128         // max chars to receive per interrupt
-#define XMIT_MAX            FIFO_DEPTH  // max chars to send per interrupt
 #define INTR_MAX            16          // max num passes per interrupt
+#define RX_TRIG_RAISE       8           // votes needed to raise the rx trigger level
+#define RX_TRIG_LOWER       2           // votes needed to lower the rx trigger level
+#define CONSOLE_BUFSIZ      4096        // serial console output queue size
 
 // check if a COM register returned a bad value
 #define ERR_CHK(x)          ((x) == 0 || (x) == 0xFF)
@@ -66,6 +68,19 @@
 
 struct com g_com[NR_SERIAL];
 
+static const struct uart_config {
+    const char *name;
+    int fifo_size;                  // usable FIFO depth, 1 if none
+    uint8_t trig_bytes[4];          // bytes for each recv_trig level
+} uart_config[NR_UART_TYPES] = {
+    [UART_UNKNOWN]  = { "unknown",  1,  { 1, 1, 1, 1 } },
+    [UART_8250]     = { "8250",     1,  { 1, 1, 1, 1 } },
+    [UART_16450]    = { "16450",    1,  { 1, 1, 1, 1 } },
+    [UART_16550]    = { "16550",    1,  { 1, 1, 1, 1 } },
+    [UART_16550A]   = { "16550A",   16, { 1, 4, 8, 14 } },
+    [UART_16750]    = { "16750",    64, { 1, 16, 32, 56 } },
+};
+
 // "serial" prefix refers to TTY functions
 // "com" prefix refers to UART functions
 
@@ -102,10 +117,14 @@ static void com2_irq(int irq, struct iregs *regs);
 static void com_interrupt(struct com *com, struct iregs *regs);
 
 static void shadow_regs(struct com *com);
+static bool probe_uart(struct com *com);
+static enum uart_type detect_uart(struct com *com);
 static bool set_baud(struct com *com, int baud_divisor);
 static bool set_mode(struct com *com,
     enum word_length wls, enum parity parity, enum stop_bits stb);
 static void set_fifo(struct com *com, bool enabled, enum recv_trig depth);
+static void set_rx_trig(struct com *com, enum recv_trig depth);
+static void adapt_rx_trig(struct com *com, int count, bool overrun);
 
 static void tx_enable(struct com *com);
 static void tx_disable(struct com *com);
@@ -113,6 +132,7 @@ static void tx_disable(struct com *com);
 static void check_line_status(struct com *com);
 static void check_modem_status(struct com *com);
 
+static bool tx_pending(struct com *com);
 static void send_chars(struct com *com);
 static void recv_chars(struct com *com);
 
@@ -122,6 +142,7 @@ static void recv_chars(struct com *com);
 static int get_modem_info(struct com *com, int *user_info);
 static int set_modem_info(struct com *com, const int *user_info);
 static int get_modem_stats(struct com *com, struct serial_stats *user_stats);
+static int get_serial_info(struct com *com, struct serial_info *user_info);
 
 // ----------------------------------------------------------------------------
 
@@ -156,11 +177,18 @@ int tty_get_com(struct tty *tty, struct com **com)
 
 // ----------------------------------------------------------------------------
 //                        Serial Console Interface
-// Unlike the TTY, the serial console does not use interrupts, instead relying
-// on polling to determine when to transmit and receive characters.
+// Console output is queued and sent by the THRE interrupt, so a kprint never
+// waits on the UART. Until the COM IRQs are hooked up, and again once
+// console_sync() is called for a panic or crash, output is sent by polling
+// instead. Input is always polled.
 
 #if SERIAL_CONSOLE
 
+static struct ring con_ring;            // console output, drained by THRE interrupt
+static char _con_buf[CONSOLE_BUFSIZ];
+static bool con_sync = true;            // send by polling instead of queueing
+static uint32_t con_dropped;            // chars lost to a full queue
+
 static inline char wait_and_recv(struct com *com)
 {
     // TODO: timeout?
@@ -229,7 +257,12 @@ static void serial_console_setup(struct console *cons)
     com_out(com, UART_LCR, 0x03);  // 8 data bits, no party, 1 stop bit
     com_out(com, UART_MCR, 0x0B);  // DTR RTS OUT2
     com_out(com, UART_IER, 0);     // no interrupts
-    com_out(com, UART_FCR, 0xC7);  // use fifo
+    set_fifo(com, uart_config[com->type].fifo_size > 1, RCVR_TRIG_14);
+
+    // output is polled until init_serial() hooks up the IRQs
+    ring_init(&con_ring, _con_buf, sizeof(_con_buf));
+    com->ier._value = 0;
+    com->console = true;
 
     // clear pending reads
     (void) com_in(com, UART_LSR);
@@ -237,20 +270,22 @@ static void serial_console_setup(struct console *cons)
     (void) com_in(com, UART_IIR);
 }
 
-static int serial_console_write(struct console *cons, const char *buf, size_t count)
+static int serial_console_poll(struct com *com, const char *buf, size_t count)
 {
-    struct com *com;
     const char *p;
+    uint32_t flags;
     uint8_t ier;
 
-    // get port info
-    com = get_com(cons->index);
-    assert(com->num == cons->index);
-
     // disable interrupts
+    cli_save(flags);
     ier = com_in(com, UART_IER);
     com_out(com, UART_IER, 0);
 
+    // send what's still queued first, so output stays in order
+    while (!ring_empty(&con_ring)) {
+        wait_and_send(com, ring_get(&con_ring));
+    }
+
     // send chars
     p = buf;
     while (*p != '\0' && (p - buf) < count) {
@@ -263,9 +298,80 @@ static int serial_console_write(struct console *cons, const char *buf, size_t co
 
     // restore interrupts and return
     com_out(com, UART_IER, ier);
+    restore_flags(flags);
     return (p - buf);
 }
 
+static void con_put(char c)
+{
+    if (!ring_put(&con_ring, c)) {
+        con_dropped++;
+    }
+}
+
+static int serial_console_write(struct console *cons, const char *buf, size_t count)
+{
+    struct com *com;
+    uint32_t flags;
+    size_t i;
+
+    // get port info
+    com = get_com(cons->index);
+    assert(com->num == cons->index);
+
+    if (con_sync) {
+        return serial_console_poll(com, buf, count);
+    }
+
+    // queue chars, dropping what doesn't fit rather than waiting for room
+    cli_save(flags);
+    for (i = 0; i < count && buf[i] != '\0'; i++) {
+        if (buf[i] == '\n') {
+            con_put('\r');
+        }
+        con_put(buf[i]);
+    }
+
+    // enable the THRE interrupt; not using tx_enable(), it might kprint
+    if (!ring_empty(&con_ring) && !com->ier.thre) {
+        com->ier.thre = 1;
+        com_out(com, UART_IER, com->ier._value);
+    }
+    restore_flags(flags);
+
+    return i;
+}
+
+static void serial_console_sync(struct console *cons)
+{
+    struct com *com;
+
+    // poll from now on, starting with whatever is queued
+    com = get_com(cons->index);
+    con_sync = true;
+    serial_console_poll(com, "", 0);
+}
+
+static size_t send_console_chars(struct com *com, size_t max)
+{
+    const char *ptr;
+    size_t count;
+    size_t sent;
+
+    for (sent = 0; sent < max; sent += count) {
+        count = min(ring_read_region(&con_ring, &ptr), max - sent);
+        if (count == 0) {
+            break;
+        }
+        for (size_t i = 0; i < count; i++) {
+            com_out(com, UART_TX, ptr[i]);
+        }
+        ring_skip(&con_ring, count);
+    }
+
+    return sent;
+}
+
 static int serial_console_getc(struct console *cons)
 {
     struct com *com;
@@ -296,7 +402,8 @@ struct console serial_console =
     .device = serial_console_device,
     .setup = serial_console_setup,
     .write = serial_console_write,
-    .getc = serial_console_getc
+    .getc = serial_console_getc,
+    .sync = serial_console_sync
 };
 
 #endif
@@ -335,16 +442,16 @@ void init_serial(void)
             continue;
         }
 
-        // try storing a value in scratch reg to determine port existence
-        com_out(com, UART_SCR, 0);
-        com_out(com, UART_SCR, 0x55);
-        if (com_in(com, UART_SCR) != 0x55) {
+        if (!probe_uart(com)) {
             kprint("com%d: error: probe failed\n", com->num);
             continue;
         }
 
+        com->type = detect_uart(com);
+        com->fifo_size = uart_config[com->type].fifo_size;
         com->valid = true;
-        kprint("com%d: detected on port %Xh\n", com->num, com->io_port);
+        kprint("com%d: %s detected on port %Xh\n",
+            com->num, uart_config[com->type].name, com->io_port);
     }
 
 #if SERIAL_CONSOLE
@@ -355,6 +462,11 @@ void init_serial(void)
     irq_register(IRQ_COM2, com2_irq);
     irq_unmask(IRQ_COM1);
     irq_unmask(IRQ_COM2);
+
+#if SERIAL_CONSOLE
+    // the THRE interrupt can drain the console queue now
+    con_sync = false;
+#endif
 }
 
 // ----------------------------------------------------------------------------
@@ -386,7 +498,7 @@ static int serial_open(struct tty *tty)
 
     cli_save(flags);
 
-    // initialize ring buffer
+    // initialize ring buffers
     ring_init(&com->tx_ring, com->_txbuf, sizeof(com->_txbuf));
     com->xchar = 0;
 
@@ -403,8 +515,9 @@ static int serial_open(struct tty *tty)
         ret = -EIO; goto done;
     }
 
-    // enable FIFOs and set default trigger level (14 bytes)
-    set_fifo(com, true, RCVR_TRIG_14);
+    // enable FIFOs if they work, starting at the lowest trigger level;
+    // adapt_rx_trig() raises it if input starts streaming in
+    set_fifo(com, uart_config[com->type].fifo_size > 1, RCVR_TRIG_1);
 
     // set modem control
     com->mcr._value = 0;
@@ -424,6 +537,9 @@ static int serial_open(struct tty *tty)
     com->ier.rda = 1;   // interrupt when data ready to read
     com->ier.rls = 1;   // interrupt when line status changes
     com->ier.ms = 1;    // interrupt when modem status changes
+#if SERIAL_CONSOLE
+    com->ier.thre = com->console && !ring_empty(&con_ring);
+#endif
     com_out(com, UART_IER, com->ier._value);
 
     // reset statistics
@@ -491,6 +607,9 @@ static int serial_ioctl(struct tty *tty, int op, void *arg)
 
         case TIOCGICOUNT:
             return get_modem_stats(com, (struct serial_stats *) arg);
+
+        case TIOCGSERIAL:
+            return get_serial_info(com, (struct serial_info *) arg);
     }
 
     return -ENOTTY;
@@ -518,8 +637,7 @@ static int serial_write(struct tty *tty, const char *buf, size_t count)
 {
     uint32_t flags;
     struct com *com;
-    size_t room;
-    const char *ptr;
+    size_t nwritten;
     int ret;
 
     // check params
@@ -536,18 +654,8 @@ static int serial_write(struct tty *tty, const char *buf, size_t count)
     // disable interrupts while poking TX buffer
     cli_save(flags);
 
-    // calculate remaining buffer space
-    room = ring_length(&com->tx_ring) - ring_count(&com->tx_ring);
-    if (count > room) {
-        count = room;
-    }
-
-    // fill the TX buffer
-    ptr = buf;
-    while (count > 0) {
-        ring_put(&com->tx_ring, *ptr);
-        ptr++; count--;
-    }
+    // fill the TX buffer, as much as will fit
+    nwritten = ring_write(&com->tx_ring, buf, count);
 
 #if CHATTY_COM
     if (ring_full(&com->tx_ring)) {
@@ -561,7 +669,7 @@ static int serial_write(struct tty *tty, const char *buf, size_t count)
 
     // enable interrupts and return
     restore_flags(flags);
-    return ptr - buf;
+    return nwritten;
 }
 
 static size_t serial_write_room(struct tty *tty)
@@ -576,7 +684,7 @@ static size_t serial_write_room(struct tty *tty)
     }
 
     cli_save(flags);
-    room = ring_length(&com->tx_ring) - ring_count(&com->tx_ring);
+    room = ring_space(&com->tx_ring);
     restore_flags(flags);
 
     return room;
@@ -692,6 +800,64 @@ static void shadow_regs(struct com *com)
     com->msr._value = com_in(com, UART_MSR);
 }
 
+static bool probe_uart(struct com *com)
+{
+    uint8_t ier, ier_rdbk0, ier_rdbk1;
+
+    // the low nybble of IER should read back whatever we put there
+    ier = com_in(com, UART_IER);
+    com_out(com, UART_IER, 0);
+    ier_rdbk0 = com_in(com, UART_IER) & 0x0F;
+    com_out(com, UART_IER, 0x0F);
+    ier_rdbk1 = com_in(com, UART_IER) & 0x0F;
+    com_out(com, UART_IER, ier);
+
+    return ier_rdbk0 == 0 && ier_rdbk1 == 0x0F;
+}
+
+static enum uart_type detect_uart(struct com *com)
+{
+    enum uart_type type;
+    uint8_t lcr, iir0, iir1;
+
+    // 8250 has no scratch register
+    com_out(com, UART_SCR, 0x55);
+    if (com_in(com, UART_SCR) != 0x55) {
+        return UART_8250;
+    }
+    com_out(com, UART_SCR, 0xAA);
+    if (com_in(com, UART_SCR) != 0xAA) {
+        return UART_8250;
+    }
+
+    // IIR reports the FIFO state in its top two bits once they're enabled
+    com_out(com, UART_FCR, UART_FCR_EN);
+    switch (com_in(com, UART_IIR) >> 6) {
+        case 0: type = UART_16450; break;
+        case 2: type = UART_16550; break;
+        case 3: type = UART_16550A; break;
+        default: type = UART_UNKNOWN; break;
+    }
+
+    // 16750 can switch on its 64-byte FIFOs, but only with DLAB set; IIR
+    // bit 5 tells us if it took
+    if (type == UART_16550A) {
+        lcr = com_in(com, UART_LCR);
+        com_out(com, UART_LCR, lcr | UART_LCR_DLAB);
+        com_out(com, UART_FCR, UART_FCR_EN | UART_FCR_FIFO64);
+        iir0 = com_in(com, UART_IIR) >> 5;
+        com_out(com, UART_FCR, UART_FCR_EN);
+        com_out(com, UART_LCR, lcr);
+        iir1 = com_in(com, UART_IIR) >> 5;
+        if (iir0 == 7 && iir1 == 6) {
+            type = UART_16750;
+        }
+    }
+
+    com_out(com, UART_FCR, 0);
+    return type;
+}
+
 static bool set_baud(struct com *com, int baud_divisor)
 {
     uint8_t div_lo, div_hi;
@@ -750,6 +916,7 @@ static bool set_mode(struct com *com,
 static void set_fifo(struct com *com, bool enabled, enum recv_trig depth)
 {
     struct fcr fcr;
+    uint8_t lcr;
 
     // program FIFO control register
     fcr._value = 0;
@@ -760,7 +927,78 @@ static void set_fifo(struct com *com, bool enabled, enum recv_trig depth)
         fcr.tx_reset = 1;
         fcr.trig = depth;
     }
+
+    if (enabled && com->type == UART_16750) {
+        // 64-byte mode can only be switched on with DLAB set
+        fcr.fifo64 = 1;
+        lcr = com_in(com, UART_LCR);
+        com_out(com, UART_LCR, lcr | UART_LCR_DLAB);
+        com_out(com, UART_FCR, fcr._value);
+        com_out(com, UART_LCR, lcr);
+    }
+    else {
+        com_out(com, UART_FCR, fcr._value);
+    }
+
+    com->fifo_size = (enabled) ? uart_config[com->type].fifo_size : 1;
+    com->rx_trig = depth;
+    com->rx_trig_votes = 0;
+}
+
+static void set_rx_trig(struct com *com, enum recv_trig depth)
+{
+    struct fcr fcr;
+
+    // change the trigger level without resetting the FIFOs; FIFO64 sticks
+    // since DLAB is clear
+    fcr._value = 0;
+    fcr.enable = 1;
+    fcr.trig = depth;
     com_out(com, UART_FCR, fcr._value);
+
+    com->rx_trig = depth;
+    com->rx_trig_votes = 0;
+
+#if CHATTY_COM && PRINT_RX_TRIG
+    COM_WARN("com%d: rx trigger %d bytes\n",
+        com->num, uart_config[com->type].trig_bytes[depth]);
+#endif
+}
+
+static void adapt_rx_trig(struct com *com, int count, bool overrun)
+{
+    int trig_bytes;
+
+    if (com->fifo_size <= 1) {
+        return;
+    }
+
+    // the FIFO filled before we got to it; lower the trigger right away to
+    // leave more room for the next batch
+    if (overrun) {
+        if (com->rx_trig > RCVR_TRIG_1) {
+            set_rx_trig(com, com->rx_trig - 1);
+        }
+        return;
+    }
+
+    // a timeout means input stopped short of the trigger level, so chars sat
+    // in the FIFO waiting for it; a steady stream of trigger-level interrupts
+    // means input is keeping up with it, so we can take fewer interrupts
+    trig_bytes = uart_config[com->type].trig_bytes[com->rx_trig];
+    if (com->iir.timeout) {
+        com->rx_trig_votes = min(com->rx_trig_votes, 0) - 1;
+    }
+    else if (count >= trig_bytes) {
+        com->rx_trig_votes = max(com->rx_trig_votes, 0) + 1;
+    }
+
+    if (com->rx_trig_votes >= RX_TRIG_RAISE && com->rx_trig < RCVR_TRIG_14) {
+        set_rx_trig(com, com->rx_trig + 1);
+    }
+    else if (com->rx_trig_votes <= -RX_TRIG_LOWER && com->rx_trig > RCVR_TRIG_1) {
+        set_rx_trig(com, com->rx_trig - 1);
+    }
 }
 
 static int get_modem_info(struct com *com, int *user_info)
@@ -817,11 +1055,34 @@ static int get_modem_stats(struct com *com, struct serial_stats *user_stats)
 
     cli_save(flags);
     stats = com->stats;
+#if SERIAL_CONSOLE
+    if (com->console) {
+        stats.n_con_dropped = con_dropped;
+    }
+#endif
     restore_flags(flags);
 
     return copy_to_user(user_stats, &stats, sizeof(struct serial_stats));
 }
 
+static int get_serial_info(struct com *com, struct serial_info *user_info)
+{
+    struct serial_info info;
+    uint32_t flags;
+
+    cli_save(flags);
+    info.type = com->type;
+    info.port = com->io_port;
+    info.baud_divisor = com->baud_divisor;
+    info.fifo_size = com->fifo_size;
+    info.rx_trig = (com->fifo_size > 1)
+        ? uart_config[com->type].trig_bytes[com->rx_trig]
+        : 1;
+    restore_flags(flags);
+
+    return copy_to_user(user_info, &info, sizeof(struct serial_info));
+}
+
 static void tx_enable(struct com *com)
 {
     if (!com->ier.thre) {
@@ -929,46 +1190,87 @@ static void check_line_status(struct com *com)
     }
 }
 
+static bool tx_pending(struct com *com)
+{
+#if SERIAL_CONSOLE
+    if (com->console && !ring_empty(&con_ring)) {
+        return true;
+    }
+#endif
+    if (!com->open) {
+        return false;
+    }
+    return com->xchar || (!ring_empty(&com->tx_ring)
+        && !com->tty->stopped && !com->tty->hw_stopped);
+}
+
 static void send_chars(struct com *com)
 {
-    char c;
-    int count;
+    const char *ptr;
+    size_t count;
+    size_t sent;
+
+    // the transmitter is empty, so we can fill the whole FIFO
+    sent = 0;
 
     // transmit high-priority control char
-    if (com->xchar) {
+    if (com->open && com->xchar) {
         com_out(com, UART_TX, com->xchar);
         com->xchar = 0;
         com->stats.n_xchar++;
+        sent++;
     }
 
-    // no chars to send or output stopped? disable transmitter
-    if (ring_empty(&com->tx_ring) || com->tty->stopped || com->tty->hw_stopped) {
-        tx_disable(com);
-        return;
+#if SERIAL_CONSOLE
+    // console output goes ahead of the tty's, but never ahead of XON/XOFF
+    if (com->console && sent < (size_t) com->fifo_size) {
+        sent += send_console_chars(com, com->fifo_size - sent);
     }
+#endif
 
-    // send chars
-    count = XMIT_MAX;
-    do {
-        c = ring_get(&com->tx_ring);
-        com_out(com, UART_TX, c);
-        if (ring_empty(&com->tx_ring)) {
-            break;
+    // send chars straight out of the ring, in at most two runs if it wraps,
+    // unless output is stopped
+    if (com->open && !com->tty->stopped && !com->tty->hw_stopped) {
+        for (; sent < (size_t) com->fifo_size; sent += count) {
+            count = min(ring_read_region(&com->tx_ring, &ptr), com->fifo_size - sent);
+            if (count == 0) {
+                break;
+            }
+            for (size_t i = 0; i < count; i++) {
+                com_out(com, UART_TX, ptr[i]);
+            }
+            ring_skip(&com->tx_ring, count);
         }
-    } while (--count > 0);
+    }
 
     // nothing left to send? disable transmitter
-    if (ring_empty(&com->tx_ring)) {
+    if (!tx_pending(com)) {
         tx_disable(com);
-        return;
     }
 }
 
+static char rx_flag(struct com *com)
+{
+    // LSR errors belong to the char at the top of the FIFO
+    if (com->lsr.brk) {
+        return TTY_BREAK;
+    }
+    if (com->lsr.pe) {
+        return TTY_PARITY;
+    }
+    if (com->lsr.fe) {
+        return TTY_FRAME;
+    }
+    if (com->lsr.oe) {
+        return TTY_OVERRUN;
+    }
+    return TTY_NORMAL;
+}
+
 static void recv_chars(struct com *com)
 {
-    char c;
-    struct tty *tty = com->tty;
-    struct tty_ldisc *ldisc = tty->ldisc;
+    char c, flag;
+    bool overrun;
     int count;
 
     // was there a timeout?
@@ -979,26 +1281,37 @@ static void recv_chars(struct com *com)
 #endif
     }
 
-    // receive chars while data ready
-    count = RECV_MAX;
+    // drain the FIFO into the flip buffer while data ready
+    count = 0;
+    overrun = false;
     do {
-        // accept char and put it in the ldisc
+        overrun |= com->lsr.oe;
+        flag = rx_flag(com);
         c = com_in(com, UART_RX);
-        ldisc->recv(tty, &c, 1);
+        if (!tty_insert_flip_char(com->tty, c, flag)) {
+            com->stats.n_rx_dropped++;
+        }
+        count++;
 
         // read new line status, continue receiving while data is available
         check_line_status(com);
-        if (!com->lsr.dr) {
-            break;
-        }
         // ...or until we've reached the limit
-    } while (--count > 0);
+    } while (com->lsr.dr && count < RECV_MAX);
 
 #if CHATTY_COM
-    if (!count) {
+    if (com->lsr.dr) {
         COM_WARN("com%d: receive max reached!\n", com->num);
     }
 #endif
+
+    if ((uint32_t) count > com->stats.n_rx_max) {
+        com->stats.n_rx_max = count;
+    }
+
+    adapt_rx_trig(com, count, overrun);
+
+    // have the whole batch handed to the ldisc
+    tty_flip_buffer_push(com->tty);
 }
 
 static void com_interrupt(struct com *com, struct iregs *regs)
@@ -1026,16 +1339,21 @@ static void com_interrupt(struct com *com, struct iregs *regs)
     }
 #endif
 
+    com->stats.n_intr++;
+
     npass = 0;
     do {
         check_line_status(com);     // reads LSR
 
-        // handle rx
-        if (com->iir.id == ID_RDA || com->iir.timeout || com->lsr.dr) {
-            recv_chars(com);
-        }
+        // a console port that isn't open as a TTY only transmits
+        if (com->open) {
+            // handle rx
+            if (com->iir.id == ID_RDA || com->iir.timeout || com->lsr.dr) {
+                recv_chars(com);
+            }
 
-        check_modem_status(com);    // reads MSR
+            check_modem_status(com);    // reads MSR
+        }
 
         // handle tx
         if (com->iir.id == ID_THRE || com->lsr.thre) {
@@ -1058,13 +1376,13 @@ static void com_interrupt(struct com *com, struct iregs *regs)
 #endif
 }
 
-#define _do_com_irq(port,regs)      \
-do {                                \
-    struct com *__c;                \
-    __c = get_com(port);            \
-    if (__c->open) {                \
-        com_interrupt(__c, regs);   \
-    }                               \
+#define _do_com_irq(port,regs)          \
+do {                                    \
+    struct com *__c;                    \
+    __c = get_com(port);                \
+    if (__c->open || __c->console) {    \
+        com_interrupt(__c, regs);       \
+    }                                   \
 } while (0);
 
 static void com1_irq(int irq, struct iregs *regs)
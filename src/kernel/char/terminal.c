@@ -24,6 +24,7 @@
 #include <i386/bitops.h>
 #include <i386/boot.h>
 #include <i386/cpu.h>
+#include <i386/dispatch.h>
 #include <i386/interrupt.h>
 #include <i386/io.h>
 #include <i386/paging.h>
@@ -407,7 +408,7 @@ int switch_terminal(int num)
         return -EINVAL;
     }
 
-    pde_t *pgdir;
+    struct map_batch batch;
 
     uint32_t flags;
     cli_save(flags);
@@ -428,40 +429,26 @@ int switch_terminal(int num)
     curr->framebuf = get_terminal_fb(curr->number);
     next->framebuf = get_terminal_fb(next->number);
 
-    pgdir = (pde_t *) get_pgdir();
-
-#if HIGHER_GROUND
-    // enable kernel identity mapping so we can operate on page tables
-    pde_t *ident_pde = &pgdir[0];
-    *ident_pde = __mkpde((uint32_t) __page_tbl, _PAGE_RW);
-#endif
-
     // identity map old frame buffer, so it will write to back buffer
+    map_batch_init(&batch);
     for (int i = 0; i < FB_SIZE_PAGES; i++) {
         uint32_t fb_page = (uint32_t) curr->framebuf + (i << PAGE_SHIFT);
-        pte_t *pte = pte_offset(pgdir, fb_page);
-        *pte = __mkpte(PHYSICAL_ADDR(fb_page), _PAGE_RW);
+        map_batch_add(&batch, fb_page, PHYSICAL_ADDR(fb_page), _PAGE_RW);
     }
-    flush_tlb();
+    map_batch_commit(&batch);
 
     // swap buffers
-    memcpy(curr->framebuf, (void *) fb_info.framebuf, FB_SIZE);
-    memcpy((void *) fb_info.framebuf, next->framebuf, FB_SIZE);
+    g_cpu_ops.memcpy(curr->framebuf, (void *) fb_info.framebuf, FB_SIZE);
+    g_cpu_ops.memcpy((void *) fb_info.framebuf, next->framebuf, FB_SIZE);
     curr = next;
 
     // map new frame buffer to VGA
     for (int i = 0; i < FB_SIZE_PAGES; i++) {
         uint32_t fb_page = (uint32_t) curr->framebuf + (i << PAGE_SHIFT);
         uint32_t vga_page = fb_info.framebuf + (i << PAGE_SHIFT);
-        pte_t *pte = pte_offset(pgdir, fb_page);
-        *pte = __mkpte(PHYSICAL_ADDR(vga_page), _PAGE_RW);
+        map_batch_add(&batch, fb_page, PHYSICAL_ADDR(vga_page), _PAGE_RW);
     }
-
-#if HIGHER_GROUND
-    pde_clear(ident_pde);
-#endif
-
-    flush_tlb();
+    map_batch_commit(&batch);
 
     update_vga_state(curr);
     g_currterm = curr->number;
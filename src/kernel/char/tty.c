@@ -21,10 +21,12 @@
 
 #include <errno.h>
 #include <i386/boot.h>
+#include <i386/interrupt.h>
 #include <kernel/char.h>
 #include <kernel/config.h>
 #include <kernel/fs.h>
 #include <kernel/ioctls.h>
+#include <kernel/irq.h>
 #include <kernel/ohwes.h>
 #include <kernel/pool.h>
 #include <kernel/queue.h>
@@ -38,10 +40,19 @@ static struct termios default_termios = {
     .c_line = N_TTY,
     .c_iflag = ICRNL | IXON,
     .c_oflag = OPOST | ONLCR,
-    .c_lflag = ECHO | ECHOCTL,
+    .c_lflag = ICANON | ECHO | ECHOE | ECHOCTL,
+    .c_cc = {
+        [VEOF]      = 0x04,     // ^D
+        [VERASE]    = 0x7F,     // DEL
+        [VKILL]     = 0x15,     // ^U
+        [VWERASE]   = 0x17,     // ^W
+        [VSTART]    = 0x11,     // ^Q
+        [VSTOP]     = 0x13,     // ^S
+    },
 };
 
 static void default_write_char(struct tty *tty, char c);
+static void tty_bottom_half(void);
 
 //
 // tty file operations
@@ -126,6 +137,8 @@ void init_tty(void)
         ttys[i].device = __mkdev(TTY_MAJOR, i);
     }
 
+    init_bh(BH_TTY, tty_bottom_half);
+
     init_kb();
     init_n_tty();
     init_serial();
@@ -151,6 +164,10 @@ int tty_open_internal(struct tty *tty)
     // associate termios
     tty->termios = default_termios;
 
+    // nothing received yet
+    tty->flip.buf_num = 0;
+    tty->flip.count = 0;
+
     // associate and open line discipline
     tty->ldisc = &ldiscs[N_TTY];
     if (!tty->ldisc->open) {
@@ -228,6 +245,46 @@ void tty_flush(struct tty *tty)
     }
 }
 
+void tty_flip_buffer_push(struct tty *tty)
+{
+    (void) tty;
+    mark_bh(BH_TTY);
+}
+
+static void flush_to_ldisc(struct tty *tty)
+{
+    uint32_t flags;
+    const char *cp, *fp;
+    int count;
+
+    // take the half the ISR was filling and give it the other one; the ldisc
+    // is done with that one, since we only ever hand it one half at a time
+    cli_save(flags);
+    count = tty->flip.count;
+    if (count == 0) {
+        restore_flags(flags);
+        return;
+    }
+    cp = &tty->flip.char_buf[tty->flip.buf_num * TTY_FLIPBUF_SIZE];
+    fp = &tty->flip.flag_buf[tty->flip.buf_num * TTY_FLIPBUF_SIZE];
+    tty->flip.buf_num ^= 1;
+    tty->flip.count = 0;
+    restore_flags(flags);
+
+    tty->ldisc->recv(tty, cp, fp, count);
+}
+
+static void tty_bottom_half(void)
+{
+    // hand received chars to the ldisc with interrupts enabled, so echo and
+    // the rest of the input processing doesn't hold off other interrupts
+    for (int i = 1; i < NR_TTY; i++) {
+        if (ttys[i].open && ttys[i].flip.count > 0) {
+            flush_to_ldisc(&ttys[i]);
+        }
+    }
+}
+
 static int tty_open(struct inode *inode, struct file *file)
 {
     int ret;
@@ -380,20 +437,46 @@ static int get_termios(struct tty *tty, struct termios *user_termios)
 
 static int set_termios(struct tty *tty, const struct termios *user_termios)
 {
-    // TODO: flush buffers, prevent new input, etc. before overwriting termios
-    if (!copy_from_user(&tty->termios, user_termios, sizeof(struct termios))) {
+    struct termios termios;
+    uint32_t flags;
+
+    if (!copy_from_user(&termios, user_termios, sizeof(struct termios))) {
         return -EFAULT;
     }
+
+    // TODO: flush output before overwriting termios
+    cli_save(flags);
+    if ((termios.c_lflag ^ tty->termios.c_lflag) & ICANON) {
+        // pending input is queued differently in each mode, so drop it
+        if (tty->ldisc->clear) {
+            tty->ldisc->clear(tty);
+        }
+    }
+    tty->termios = termios;
+    restore_flags(flags);
+
     return 0;
 }
 
 static int tiocsti(struct tty *tty, const char *user_char)
 {
+    uint32_t flags;
+    bool queued;
     char c;
+
     if (!copy_from_user(&c, user_char, sizeof(char))) {
         return -EFAULT;
     }
 
-    tty->ldisc->recv(tty, &c, 1);
+    // go through the flip buffer like received chars do, so only the bottom
+    // half ever feeds the ldisc
+    cli_save(flags);
+    queued = tty_insert_flip_char(tty, c, TTY_NORMAL);
+    restore_flags(flags);
+    if (!queued) {
+        return -EAGAIN;
+    }
+
+    tty_flip_buffer_push(tty);
     return 0;
 }
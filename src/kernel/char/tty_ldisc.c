@@ -25,8 +25,10 @@
 #include <i386/interrupt.h>
 #include <kernel/config.h>
 #include <kernel/kernel.h>
+#include <kernel/ohwes.h>
 #include <kernel/queue.h>
 #include <kernel/tty.h>
+#include <kernel/wait.h>
 
 //
 // line discipline tty operations
@@ -36,7 +38,7 @@ static int n_tty_close(struct tty *);
 static ssize_t n_tty_read(struct tty *tty, char *buf, size_t count);
 static ssize_t n_tty_write(struct tty *, const char *buf, size_t count);
 static int n_tty_ioctl(struct tty *, int op, void *arg);
-static void n_tty_recv(struct tty *, char *buf, size_t count);
+static void n_tty_recv(struct tty *, const char *buf, const char *flags, size_t count);
 static size_t n_tty_recv_room(struct tty *);
 static void n_tty_clear(struct tty *tty);
 
@@ -54,20 +56,42 @@ static struct tty_ldisc n_tty = {
     .recv_room = n_tty_recv_room,
 };
 
+//
+// In canonical mode, n_tty_recv edits the pending line in 'line' and commits
+// it to rx_ring in one piece once it's complete, preceded by a byte holding
+// its length. A zero-length line is an EOF. n_tty_read tracks how much of the
+// current line is left in 'read_left'.
+//
 struct n_tty_ldisc_data {
-    struct ring rx_ring;
+    struct spsc_ring rx_ring;   // filled by n_tty_recv (bottom half), drained by n_tty_read
+    struct wait_queue read_wait;// readers waiting for rx_ring to fill
     char _rxbuf[TTY_BUFFER_SIZE];
+
+    char line[1+TTY_LINE_MAX];  // canonical: length byte + line being edited
+    size_t line_len;            // canonical: chars in the line being edited
+    size_t read_left;           // canonical: chars left in the line being read
 };
 static struct n_tty_ldisc_data ldisc_data[NR_TTY];
 
 static int opost(struct tty *tty, char c);
+static ssize_t opost_block(struct tty *tty, const char *buf, size_t count);
 static int echo(struct tty *tty, char c);
 static void write_char(struct tty *tty, char c);
+static void erase_char(struct tty *tty);
+static void commit_line(struct tty *tty);
+static void recv_canon(struct tty *tty, char c);
+static ssize_t read_canon(struct tty *tty, char *buf, size_t count);
 static void unthrottle_tty(struct tty *tty);
 static void throttle_tty(struct tty *tty);
 static void start_tty(struct tty *tty);
 static void stop_tty(struct tty *tty);
 
+// check whether a char matches an enabled control character
+static inline bool is_cc(char c, cc_t cc)
+{
+    return cc != _POSIX_VDISABLE && (cc_t) c == cc;
+}
+
 void init_n_tty(void)
 {
     if (tty_register_ldisc(N_TTY, &n_tty)) {
@@ -82,7 +106,10 @@ static int n_tty_open(struct tty *tty)
     }
 
     struct n_tty_ldisc_data *data = &ldisc_data[_DEV_MIN(tty->device)];
-    ring_init(&data->rx_ring, data->_rxbuf, TTY_BUFFER_SIZE);
+    spsc_init(&data->rx_ring, data->_rxbuf, TTY_BUFFER_SIZE);
+    init_wait_queue(&data->read_wait);
+    data->line_len = 0;
+    data->read_left = 0;
     tty->ldisc_data = data;
     return 0;
 }
@@ -100,14 +127,16 @@ void n_tty_clear(struct tty *tty)
 
     struct n_tty_ldisc_data *ldisc_data;
     ldisc_data = (struct n_tty_ldisc_data *) tty->ldisc_data;
-    ring_clear(&ldisc_data->rx_ring);
+    spsc_clear(&ldisc_data->rx_ring);
+    ldisc_data->line_len = 0;
+    ldisc_data->read_left = 0;
 }
 
 static ssize_t n_tty_read(struct tty *tty, char *buf, size_t count)
 {
     struct n_tty_ldisc_data *ldisc_data;
-    uint32_t flags;
     size_t nremain;
+    size_t nread;
     char *ptr;
     int ret;
 
@@ -119,12 +148,16 @@ static ssize_t n_tty_read(struct tty *tty, char *buf, size_t count)
         return -ENXIO;
     }
 
+    if (L_ICANON(tty)) {
+        return read_canon(tty, buf, count);
+    }
+
     ldisc_data = (struct n_tty_ldisc_data *) tty->ldisc_data;
     ptr = buf;
 
     ret = 0;
     while (count > 0) {
-        nremain = ring_count(&ldisc_data->rx_ring);
+        nremain = spsc_count(&ldisc_data->rx_ring);
         if (!nremain) {
             if (tty->file->f_oflag & O_NONBLOCK) {
                 if ((ptr - buf) == 0) {
@@ -133,14 +166,14 @@ static ssize_t n_tty_read(struct tty *tty, char *buf, size_t count)
                 }
                 break;
             }
-            continue;   // spin until a char appears, TODO: timeout?
+            // sleep until a char appears, TODO: timeout?
+            wait_event_idle(&ldisc_data->read_wait, spsc_count(&ldisc_data->rx_ring) != 0);
+            continue;
         }
 
-        // grab the character
-        cli_save(flags);
-        *ptr = ring_get(&ldisc_data->rx_ring);
-        ptr++; count--;
-        restore_flags(flags);
+        // grab as many characters as we can
+        nread = spsc_read(&ldisc_data->rx_ring, ptr, count);
+        ptr += nread; count -= nread;
 
         // check if we can unthrottle
         if (n_tty_recv_room(tty) >= TTY_THROTTLE_THRESH) {
@@ -166,6 +199,17 @@ static ssize_t n_tty_write(struct tty *tty, const char *buf, size_t count)
     ptr = buf; ret = 0;
     while (count > 0) {
         if (O_OPOST(tty)) {
+            // pass along everything up to the next char that needs work...
+            ret = opost_block(tty, ptr, count);
+            if (ret < 0) {
+                break;
+            }
+            ptr += ret; count -= ret;
+            if (count == 0) {
+                break;
+            }
+
+            // ...then translate that one
             ret = opost(tty, *ptr);
             if (ret < 0) {  // returns -1 if no chars in buffer
                 ret = 0;
@@ -196,11 +240,9 @@ static int n_tty_ioctl(struct tty *tty, int op, void *arg)
     return -ENOTTY;
 }
 
-static void n_tty_recv(struct tty *tty, char *buf, size_t count)
+static void n_tty_recv(struct tty *tty, const char *buf, const char *flags, size_t count)
 {
-    uint32_t flags;
     struct n_tty_ldisc_data *ldisc_data;
-    char *ptr;
     char c;
 
     if (!tty || !buf) {
@@ -211,20 +253,38 @@ static void n_tty_recv(struct tty *tty, char *buf, size_t count)
     }
 
     ldisc_data = (struct n_tty_ldisc_data *) tty->ldisc_data;
-    ptr = buf;
 
-    while (count > 0) {
-        c = *ptr;
+    for (size_t i = 0; i < count; i++) {
+        c = buf[i];
+
+        // handle chars received with errors; they read as NUL unless ignored
+        if (flags) {
+            switch (flags[i]) {
+                case TTY_BREAK:
+                    if (I_IGNBRK(tty)) {
+                        continue;
+                    }
+                    c = '\0';
+                    break;
+                case TTY_FRAME:
+                case TTY_PARITY:
+                    if (I_IGNPAR(tty)) {
+                        continue;
+                    }
+                    c = '\0';
+                    break;
+            }
+        }
 
         // handle software flow control
         if (I_IXON(tty)) {
-            if (c == START_CHAR(tty)) {
+            if (is_cc(c, START_CHAR(tty))) {
                 start_tty(tty);
-                return;
+                continue;
             }
-            if (c == STOP_CHAR(tty)) {
+            if (is_cc(c, STOP_CHAR(tty))) {
                 stop_tty(tty);
-                return;
+                continue;
             }
         }
 
@@ -245,22 +305,26 @@ static void n_tty_recv(struct tty *tty, char *buf, size_t count)
                 break;
         }
 
+        // line editing
+        if (L_ICANON(tty)) {
+            recv_canon(tty, c);
+            continue;
+        }
+
         // handle character echo
         if (L_ECHO(tty)) {
             if (n_tty_recv_room(tty) <= 1) {
                 write_char(tty, '\a');  // we're full... beep!!
-                return;
+                break;
             }
             else {
                 echo(tty, c);
             }
         }
 
-        // add char to buffer
-        cli_save(flags);
-        ring_put(&ldisc_data->rx_ring, c);
-        restore_flags(flags);
-        ptr++; count--;
+        // add char to buffer and wake the reader
+        spsc_put(&ldisc_data->rx_ring, c);
+        wake_up(&ldisc_data->read_wait);
     }
 
     // flush any echoed chars
@@ -276,17 +340,149 @@ static void n_tty_recv(struct tty *tty, char *buf, size_t count)
 
 static size_t n_tty_recv_room(struct tty *tty)
 {
-    uint32_t flags;
-    size_t room;
     struct n_tty_ldisc_data *ldisc_data;
 
     ldisc_data = (struct n_tty_ldisc_data *) tty->ldisc_data;
 
-    cli_save(flags);
-    room = ring_length(&ldisc_data->rx_ring) - ring_count(&ldisc_data->rx_ring);
-    restore_flags(flags);
+    return spsc_space(&ldisc_data->rx_ring);
+}
+
+static ssize_t read_canon(struct tty *tty, char *buf, size_t count)
+{
+    struct n_tty_ldisc_data *ldisc_data;
+    size_t nread;
+    char len;
+
+    ldisc_data = (struct n_tty_ldisc_data *) tty->ldisc_data;
+    if (count == 0) {
+        return 0;
+    }
+
+    // starting a new line, wait for one to be committed and get its length
+    if (ldisc_data->read_left == 0) {
+        if (spsc_count(&ldisc_data->rx_ring) == 0) {
+            if (tty->file->f_oflag & O_NONBLOCK) {
+                return -EAGAIN;     // operation would block
+            }
+            wait_event_idle(&ldisc_data->read_wait, spsc_count(&ldisc_data->rx_ring) != 0);
+        }
+        spsc_get(&ldisc_data->rx_ring, &len);
+        ldisc_data->read_left = (unsigned char) len;
+    }
+
+    // hand over as much of the line as fits; an EOF reads zero chars
+    nread = spsc_read(&ldisc_data->rx_ring, buf, min(count, ldisc_data->read_left));
+    ldisc_data->read_left -= nread;
+
+    // check if we can unthrottle
+    if (n_tty_recv_room(tty) >= TTY_THROTTLE_THRESH) {
+        unthrottle_tty(tty);
+    }
+
+    return nread;
+}
+
+static void recv_canon(struct tty *tty, char c)
+{
+    struct n_tty_ldisc_data *ldisc_data;
+    size_t max_len;
+    size_t *len;
+
+    ldisc_data = (struct n_tty_ldisc_data *) tty->ldisc_data;
+    len = &ldisc_data->line_len;
+
+    // line editing
+    if (is_cc(c, ERASE_CHAR(tty)) || is_cc(c, WERASE_CHAR(tty)) || is_cc(c, KILL_CHAR(tty))) {
+        if (L_ECHO(tty) && !L_ECHOE(tty)) {
+            echo(tty, c);
+        }
+        if (is_cc(c, ERASE_CHAR(tty))) {
+            if (*len > 0) {
+                erase_char(tty);
+            }
+        }
+        else if (is_cc(c, WERASE_CHAR(tty))) {
+            while (*len > 0 && isspace(ldisc_data->line[*len])) {
+                erase_char(tty);
+            }
+            while (*len > 0 && !isspace(ldisc_data->line[*len])) {
+                erase_char(tty);
+            }
+        }
+        else {
+            while (*len > 0) {
+                erase_char(tty);
+            }
+        }
+        return;
+    }
+
+    // EOF ends the line without being stored; on its own it reads as EOF
+    if (is_cc(c, EOF_CHAR(tty))) {
+        if (spsc_space(&ldisc_data->rx_ring) < *len + 1) {
+            if (L_ECHO(tty)) {
+                write_char(tty, '\a');  // no room for the length byte... beep!!
+            }
+            return;
+        }
+        commit_line(tty);
+        return;
+    }
+
+    // make sure the line and its length byte will fit in the queue; the last
+    // slot in the line is held back so a newline can always end it
+    max_len = (c == '\n') ? TTY_LINE_MAX : TTY_LINE_MAX - 1;
+    if (*len >= max_len || spsc_space(&ldisc_data->rx_ring) < *len + 2) {
+        if (L_ECHO(tty)) {
+            write_char(tty, '\a');  // we're full... beep!!
+        }
+        return;
+    }
+
+    if (L_ECHO(tty)) {
+        echo(tty, c);
+    }
+    ldisc_data->line[++(*len)] = c;
+    if (c == '\n') {
+        commit_line(tty);
+    }
+}
+
+static void erase_char(struct tty *tty)
+{
+    struct n_tty_ldisc_data *ldisc_data;
+    int cols;
+    char c;
+
+    ldisc_data = (struct n_tty_ldisc_data *) tty->ldisc_data;
+    c = ldisc_data->line[ldisc_data->line_len--];
+
+    if (L_ECHO(tty) && L_ECHOE(tty)) {
+        // control chars were echoed as two columns, e.g. ^C
+        cols = (L_ECHOCTL(tty) && iscntrl(c) && c != '\t') ? 2 : 1;
+        while (cols--) {
+            write_char(tty, '\b');
+            write_char(tty, ' ');
+            write_char(tty, '\b');
+        }
+    }
+}
+
+static void commit_line(struct tty *tty)
+{
+    struct n_tty_ldisc_data *ldisc_data;
+    size_t len;
+
+    ldisc_data = (struct n_tty_ldisc_data *) tty->ldisc_data;
+    len = ldisc_data->line_len;
 
-    return room;
+    // recv_canon() made sure there's room for the line and its length
+    assert(spsc_space(&ldisc_data->rx_ring) >= len + 1);
+
+    ldisc_data->line[0] = (char) len;
+    spsc_write(&ldisc_data->rx_ring, ldisc_data->line, len + 1);
+    ldisc_data->line_len = 0;
+    wake_up(&ldisc_data->read_wait);
 }
 
 static int opost(struct tty *tty, char c)
@@ -318,6 +514,30 @@ static int opost(struct tty *tty, char c)
     return 0;
 }
 
+static ssize_t opost_block(struct tty *tty, const char *buf, size_t count)
+{
+    size_t room;
+    size_t i;
+
+    room = tty->driver.write_room(tty);
+    count = min(count, room);
+
+    // find the run of chars opost() would write unchanged
+    for (i = 0; i < count; i++) {
+        if (buf[i] == '\r' && O_OCRNL(tty)) {
+            break;
+        }
+        if (buf[i] == '\n' && O_ONLCR(tty)) {
+            break;
+        }
+    }
+    if (i == 0) {
+        return 0;
+    }
+
+    return tty->driver.write(tty, buf, i);
+}
+
 static int echo(struct tty *tty, char c)
 {
     size_t room;
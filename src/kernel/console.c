@@ -21,6 +21,7 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include <i386/boot.h>
 #include <i386/cpu.h>
 #include <i386/io.h>
@@ -124,12 +125,38 @@ static void register_default_console(void)
     register_console(&vt_console);
 }
 
+// append to the kernel log ring, overwriting the oldest text when it's full
+static void log_write(const char *buf, size_t count)
+{
+    size_t end, chunk;
+
+#if E9_HACK
+    for (size_t i = 0; i < count; i++) {
+        outb(0xE9, buf[i]);
+    }
+#endif
+
+    if (count > KERNEL_LOG_SIZE) {
+        buf += count - KERNEL_LOG_SIZE;     // only the tail will survive
+        count = KERNEL_LOG_SIZE;
+    }
+
+    // copy in at most two pieces, wrapping at the end of the ring
+    end = (_log_start + _log_size) % KERNEL_LOG_SIZE;
+    chunk = min(count, (size_t) (KERNEL_LOG_SIZE - end));
+    memcpy(&_kernel_log[end], buf, chunk);
+    memcpy(_kernel_log, buf + chunk, count - chunk);
+
+    _log_size += count;
+    if (_log_size > KERNEL_LOG_SIZE) {
+        _log_start = (_log_start + (_log_size - KERNEL_LOG_SIZE)) % KERNEL_LOG_SIZE;
+        _log_size = KERNEL_LOG_SIZE;
+    }
+}
+
 // print a message to the console(s) and kernel log
 int console_write(const char *buf, size_t count)
 {
-    const char *p;
-    const char *line;
-    int linefeed;
     struct console *cons;
 
 #if EARLY_PRINT
@@ -142,45 +169,35 @@ int console_write(const char *buf, size_t count)
     if (count > KPRINT_MAX) {
         count = KPRINT_MAX;
     }
+    count = strnlen(buf, count);    // stop at NUL
+    if (count == 0) {
+        return 0;
+    }
 
-    p = buf;
-    linefeed = 0;
-    while ((p - buf) < count && *p != '\0') {
-        // add to the log 'til we see a linefeed or hit the end
-        for (line = p; (p - buf) < count && *p != '\0'; p++) {
-#if E9_HACK
-            outb(0xE9, *p);
-#endif
-            _kernel_log[(_log_start + _log_size) % KERNEL_LOG_SIZE] = *p;
-            if (_log_size < KERNEL_LOG_SIZE) {
-                _log_size++;
-            }
-            else {
-                _log_start += 1;
-                _log_start %= KERNEL_LOG_SIZE;
-            }
-            linefeed = (*p == '\n');
-            if (linefeed) {
-                break;
-            }
-        }
+    log_write(buf, count);
 
-        // write line to console
-        cons = g_consoles;
-        while (cons) {
-            if (cons->write) {
-                cons->write(cons, line, (p - line) + linefeed);
-            }
-            cons = cons->next;
+    cons = g_consoles;
+    while (cons) {
+        if (cons->write) {
+            cons->write(cons, buf, count);
         }
+        cons = cons->next;
+    }
+
+    return count;
+}
 
-        if (linefeed) {
-            linefeed = 0;
-            p++;
+void console_sync(void)
+{
+    struct console *cons;
+
+    cons = g_consoles;
+    while (cons) {
+        if (cons->sync) {
+            cons->sync(cons);
         }
+        cons = cons->next;
     }
-
-    return (p - buf);
 }
 
 int console_getc(void)
@@ -192,15 +209,24 @@ int console_getc(void)
     return g_consoles->getc(g_consoles);
 }
 
-int _vkprint(const char *fmt, va_list args)
+// takes formatted text straight from printf, no more than KPRINT_MAX chars
+// per message
+static int kprint_sink(void *arg, const char *buf, size_t count)
 {
-    size_t count;
-    char buf[KPRINT_MAX+1] = { };
+    size_t *avail = (size_t *) arg;
 
-    count = vsnprintf(buf, KPRINT_MAX, fmt, args);
+    count = min(count, *avail);
+    *avail -= count;
     return console_write(buf, count);
 }
 
+int _vkprint(const char *fmt, va_list args)
+{
+    size_t avail = KPRINT_MAX;
+
+    return vcbprintf(kprint_sink, &avail, fmt, args);
+}
+
 int kprint(const char *fmt, ...)
 {
     va_list args;
@@ -217,6 +243,8 @@ void __noreturn panic(const char *fmt, ...)
 {
     va_list args;
 
+    console_sync();
+
     va_start(args, fmt);
     kprint("\n\e[1;31mpanic: "); _vkprint(fmt, args); kprint("\e[0m");
     va_end(args);
@@ -25,6 +25,7 @@
 #include <kernel/kernel.h>
 #include <kernel/fs.h>
 #include <kernel/list.h>
+#include <kernel/mm.h>
 #include <kernel/pool.h>
 
 
@@ -41,18 +42,18 @@ extern struct file_ops chdev_ops;
 void init_fs(void)
 {
     list_init(&inodes);
-    inode_pool = pool_create("inodes", MAX_NR_INODES, sizeof(struct inode), 0);
+    inode_pool = pool_create("inodes", sizeof(struct inode), 0);
     if (inode_pool == INVALID_POOL) {
         panic("failed to create inode pool!");
     }
 
     list_init(&dentries);
-    dentry_pool = pool_create("dentries", MAX_NR_DENTRIES, sizeof(struct dentry), 0);
+    dentry_pool = pool_create("dentries", sizeof(struct dentry), 0);
     if (dentry_pool == INVALID_POOL) {
         panic("failed to create dentry pool!");
     }
 
-    file_pool = pool_create("files", MAX_NR_TOTAL_OPEN, sizeof(struct file), 0);
+    file_pool = pool_create("files", sizeof(struct file), 0);
     if (file_pool == INVALID_POOL) {
         panic("failed to create file pool!");
     }
@@ -70,7 +71,7 @@ void init_fs(void)
         struct dentry *dentry = NULL;
         struct inode *inode = NULL;
 
-        dentry = pool_alloc(dentry_pool, 0);
+        dentry = pool_alloc(dentry_pool, ALLOC_ZERO);
         dentry->inode = NULL;
         strncpy(dentry->name, name, DENTRY_NAME_LENGTH);
         list_add_tail(&dentries, &dentry->dentries);
@@ -80,13 +81,23 @@ void init_fs(void)
             continue;
         }
 
-        inode = pool_alloc(inode_pool, 0);
+        inode = pool_alloc(inode_pool, ALLOC_ZERO);
         inode->device = __mkdev(TTY_MAJOR, i);
         inode->fops = &chdev_ops;
         list_add_tail(&inodes, &inode->inodes);
 
         dentry->inode = inode;
     }
+
+    // create trace device dentry
+    struct dentry *dentry = pool_alloc(dentry_pool, ALLOC_ZERO);
+    struct inode *inode = pool_alloc(inode_pool, ALLOC_ZERO);
+    strncpy(dentry->name, "/dev/trace", DENTRY_NAME_LENGTH);
+    inode->device = __mkdev(TRACE_MAJOR, 0);
+    inode->fops = &chdev_ops;
+    list_add_tail(&inodes, &inode->inodes);
+    list_add_tail(&dentries, &dentry->dentries);
+    dentry->inode = inode;
 }
 
 struct inode * find_inode(struct file *file, const char *name)
@@ -120,7 +131,11 @@ int alloc_fd(struct file **file)
         return -EINVAL;
     }
 
-    struct file *f = pool_alloc(file_pool, 0);
+    if (file_pool->count >= MAX_NR_TOTAL_OPEN) {
+        return -ENFILE;
+    }
+
+    struct file *f = pool_alloc(file_pool, ALLOC_ZERO);
     if (!f) {
         return -ENOMEM;
     }
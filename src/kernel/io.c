@@ -24,6 +24,7 @@
 #include <kernel/io.h>
 #include <kernel/list.h>
 #include <kernel/kernel.h>
+#include <kernel/mm.h>
 #include <kernel/pool.h>
 #include <kernel/serial.h>
 
@@ -35,14 +36,12 @@ struct io_range {
 };
 
 list_t io_ranges_list = LIST_INITIALIZER(io_ranges_list);
-struct io_range _io_ranges_pool[MAX_NR_IO_RANGES];
 pool_t *io_ranges_pool;
 
 void init_io(void)
 {
     io_ranges_pool = pool_create(
         "io_ranges",
-        MAX_NR_IO_RANGES,
         sizeof(struct io_range), 0);
     if (io_ranges_pool == INVALID_POOL) {
         panic("failed to create io_ranges_pool!");
@@ -69,9 +68,9 @@ int reserve_io_range(uint16_t base, uint8_t count, const char *name)
         panic("I/O ranges not initialized!");
     }
 
-    new_range = pool_alloc(io_ranges_pool, 0);
+    new_range = pool_alloc(io_ranges_pool, ALLOC_ZERO);
     if (!new_range) {
-        kprint("warning: I/O range reservation list is full!\n");
+        kprint("warning: out of memory for I/O range reservation!\n");
         return -ENOMEM;
     }
 
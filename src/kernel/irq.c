@@ -22,6 +22,7 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <i386/bitops.h>
+#include <i386/cpu.h>
 #include <i386/pic.h>
 #include <i386/interrupt.h>
 #include <i386/x86.h>
@@ -37,6 +38,9 @@
 struct irq_stats {
     int spur_pic0;
     int spur_pic1;
+    uint32_t count[NR_IRQS];        // interrupts handled
+    uint32_t max_cycles[NR_IRQS];   // longest time spent in ISRs; TSC only
+    uint32_t bh_count[NR_BH];       // bottom half runs
 };
 
 static struct irq_stats _irqstats;
@@ -44,6 +48,20 @@ struct irq_stats *g_irqstats = &_irqstats;
 
 static irq_handler _isr_map[NR_IRQS][MAX_ISR];
 
+static bh_handler _bh_map[NR_BH];
+static volatile uint32_t _bh_pending;   // bitmap of marked bottom halves
+static bool _bh_running;                // bottom halves running, don't nest
+static bool _irq_tsc;                   // time ISRs with RDTSC
+
+static void run_bottom_halves(void);
+
+void init_irq(void)
+{
+    struct cpuid cpu;
+
+    _irq_tsc = get_cpu_info(&cpu) && cpu.tsc_support;
+}
+
 void irq_enable(void)
 {
     __sti();
@@ -111,6 +129,7 @@ void irq_unregister(int irq, irq_handler func)
 }
 __fastcall void handle_irq(struct iregs *regs)
 {
+    uint64_t start = 0, end = 0;
     int irq = ~regs->vec;
     bool handled = false;
     bool masked = _IRQ_MASKED(irq);
@@ -130,6 +149,10 @@ __fastcall void handle_irq(struct iregs *regs)
 
     pic_eoi(irq);
 
+    if (_irq_tsc) {
+        rdtsc(start);
+    }
+
     if (!masked) {
         for (int i = 0; i < MAX_ISR; i++) {
             irq_handler isr = _isr_map[irq][i];
@@ -140,7 +163,78 @@ __fastcall void handle_irq(struct iregs *regs)
         }
     }
 
+    if (_irq_tsc) {
+        rdtsc(end);
+        if ((uint32_t) (end - start) > g_irqstats->max_cycles[irq]) {
+            g_irqstats->max_cycles[irq] = (uint32_t) (end - start);
+        }
+    }
+    g_irqstats->count[irq]++;
+
     if (!handled) {
         alert("unhandled irq%d\n", irq);
     }
+
+    if (_bh_pending) {
+        run_bottom_halves();
+    }
+}
+
+void init_bh(int nr, bh_handler func)
+{
+    assert(nr >= 0 && nr < NR_BH);
+    _bh_map[nr] = func;
+}
+
+void mark_bh(int nr)
+{
+    uint32_t flags;
+
+    assert(nr >= 0 && nr < NR_BH);
+
+    cli_save(flags);
+    _bh_pending |= (1 << nr);
+    restore_flags(flags);
+}
+
+static void run_bottom_halves(void)
+{
+    uint32_t pending;
+
+    // called with interrupts disabled; if we interrupted a bottom half, it
+    // will pick up whatever was just marked before it finishes
+    if (_bh_running) {
+        return;
+    }
+    _bh_running = true;
+
+    while ((pending = _bh_pending) != 0) {
+        _bh_pending = 0;
+        __sti();
+        for (int nr = 0; nr < NR_BH; nr++) {
+            if ((pending & (1 << nr)) && _bh_map[nr]) {
+                _bh_map[nr]();
+                g_irqstats->bh_count[nr]++;
+            }
+        }
+        __cli();
+    }
+
+    _bh_running = false;
+}
+
+void print_irq_stats(void)
+{
+    kprint("irq: spurious pic0=%d pic1=%d\n",
+        g_irqstats->spur_pic0, g_irqstats->spur_pic1);
+    for (int irq = 0; irq < NR_IRQS; irq++) {
+        if (g_irqstats->count[irq] == 0) {
+            continue;
+        }
+        kprint("irq%-2d count=%u max_cycles=%u\n", irq,
+            g_irqstats->count[irq], g_irqstats->max_cycles[irq]);
+    }
+    for (int nr = 0; nr < NR_BH; nr++) {
+        kprint("bh%d count=%u\n", nr, g_irqstats->bh_count[nr]);
+    }
 }
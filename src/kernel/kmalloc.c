@@ -0,0 +1,229 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: kernel/kmalloc.c
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ *
+ * General-purpose kernel heap. Small objects come from one pool per size
+ * class. Anything bigger than the largest class goes straight to the buddy
+ * allocator.
+ * =============================================================================
+ */
+
+#include <kernel/kernel.h>
+#include <kernel/kmalloc.h>
+#include <kernel/mm.h>
+#include <kernel/ohwes.h>
+#include <kernel/pool.h>
+
+struct size_class {
+    size_t size;            // object size
+    const char *name;       // pool name
+    pool_t *pool;           // pool backing this class
+    struct kmalloc_stats stats;
+};
+
+// powers of two, plus 96 and 192 to cut the waste between 64-128 and 128-256
+static struct size_class _classes[] = {
+    { .size = 8,    .name = "kmalloc_8" },
+    { .size = 16,   .name = "kmalloc_16" },
+    { .size = 32,   .name = "kmalloc_32" },
+    { .size = 64,   .name = "kmalloc_64" },
+    { .size = 96,   .name = "kmalloc_96" },
+    { .size = 128,  .name = "kmalloc_128" },
+    { .size = 192,  .name = "kmalloc_192" },
+    { .size = 256,  .name = "kmalloc_256" },
+    { .size = 512,  .name = "kmalloc_512" },
+    { .size = KMALLOC_MAX_SIZE, .name = "kmalloc_1024" },
+};
+static struct kmalloc_stats _large_stats;
+static bool _kmalloc_init;
+
+static void lazy_init_kmalloc(void)
+{
+    for (int i = 0; i < countof(_classes); i++) {
+        struct size_class *cls = &_classes[i];
+        cls->pool = pool_create(cls->name, cls->size, 0);
+        if (cls->pool == INVALID_POOL) {
+            panic("kmalloc: failed to create pool '%s'!", cls->name);
+        }
+        // kfree tells slab objects from page blocks by page alignment,
+        //  which only holds for single-page slabs
+        assert(cls->pool->order == 0);
+        cls->stats.size = cls->size;
+    }
+    _kmalloc_init = true;
+}
+
+static struct size_class * size_to_class(size_t size)
+{
+    for (int i = 0; i < countof(_classes); i++) {
+        if (size <= _classes[i].size) {
+            return &_classes[i];
+        }
+    }
+    return NULL;
+}
+
+static struct size_class * pool_to_class(pool_t *pool)
+{
+    for (int i = 0; i < countof(_classes); i++) {
+        if (_classes[i].pool == pool) {
+            return &_classes[i];
+        }
+    }
+    return NULL;
+}
+
+static void * kmalloc_large(size_t size, int flags)
+{
+    int order = get_order(size);
+    if (order < 0) {
+        return NULL;
+    }
+
+    void *ptr = alloc_pages(flags, order);
+    if (ptr == NULL) {
+        return NULL;
+    }
+
+    _large_stats.nr_pages += (1 << order);
+    _large_stats.nr_active++;
+    _large_stats.nr_allocs++;
+    _large_stats.bytes_requested += size;
+    _large_stats.bytes_allocated += get_order_size(order);
+    return ptr;
+}
+
+void * kmalloc(size_t size, int flags)
+{
+    struct size_class *cls;
+    void *obj;
+
+    if (size == 0) {
+        return NULL;
+    }
+
+    if (!_kmalloc_init) {
+        lazy_init_kmalloc();
+    }
+
+    cls = size_to_class(size);
+    if (cls == NULL) {
+        return kmalloc_large(size, flags);
+    }
+
+    obj = pool_alloc(cls->pool, flags);
+    if (obj == NULL) {
+        return NULL;
+    }
+
+    cls->stats.nr_allocs++;
+    cls->stats.bytes_requested += size;
+    cls->stats.bytes_allocated += cls->size;
+    return obj;
+}
+
+void kfree(const void *ptr)
+{
+    struct size_class *cls;
+
+    if (ptr == NULL) {
+        return;
+    }
+
+    // slab objects are never page-aligned; page-aligned means alloc_pages
+    if (aligned(ptr, PAGE_SIZE)) {
+        int order = get_block_order((void *) ptr);
+        if (order < 0) {
+            warn("kfree: invalid pointer %08X\n", ptr);
+            return;
+        }
+        free_pages((void *) ptr, order);
+        _large_stats.nr_pages -= (1 << order);
+        _large_stats.nr_active--;
+        _large_stats.nr_frees++;
+        return;
+    }
+
+    cls = pool_to_class(pool_of(ptr));
+    if (cls == NULL) {
+        warn("kfree: invalid pointer %08X\n", ptr);
+        return;
+    }
+
+    pool_free(cls->pool, ptr);
+    cls->stats.nr_frees++;
+}
+
+bool get_kmalloc_stats(int index, struct kmalloc_stats *stats)
+{
+    if (index < 0 || index > countof(_classes) || stats == NULL) {
+        return false;
+    }
+
+    if (!_kmalloc_init) {
+        lazy_init_kmalloc();
+    }
+
+    if (index == countof(_classes)) {
+        *stats = _large_stats;
+    }
+    else {
+        struct size_class *cls = &_classes[index];
+        *stats = cls->stats;
+        stats->nr_pages = cls->pool->nr_slabs << cls->pool->order;
+        stats->nr_active = cls->pool->count;
+        stats->nr_total = cls->pool->capacity;
+    }
+    return true;
+}
+
+void print_kmalloc_stats(void)
+{
+    struct kmalloc_stats stats;
+    size_t total_pages = 0;
+    size_t total_used = 0;
+
+    kprint("kmalloc:  size pages active/total   allocs    frees overhead  waste\n");
+    for (int i = 0; get_kmalloc_stats(i, &stats); i++) {
+        // overhead: bytes held in pages but not allocated to anyone
+        // waste: bytes handed out beyond what was asked for (rounding)
+        size_t held = stats.nr_pages << PAGE_SHIFT;
+        size_t used = (stats.size) ? stats.nr_active * stats.size : held;
+        int overhead = (held) ? ((held - used) * 100) / held : 0;
+        int waste = (stats.bytes_allocated)
+            ? ((stats.bytes_allocated - stats.bytes_requested) * 100) / stats.bytes_allocated
+            : 0;
+
+        if (stats.size) {
+            kprint("kmalloc: %5d %5d %6d/%-6d %8d %8d %7d%% %5d%%\n",
+                stats.size, stats.nr_pages, stats.nr_active, stats.nr_total,
+                stats.nr_allocs, stats.nr_frees, overhead, waste);
+        }
+        else {
+            kprint("kmalloc: pages %5d %6d/%-6s %8d %8d %7d%% %5d%%\n",
+                stats.nr_pages, stats.nr_active, "-",
+                stats.nr_allocs, stats.nr_frees, overhead, waste);
+        }
+
+        total_pages += stats.nr_pages;
+        total_used += used;
+    }
+
+    kprint("kmalloc: %d pages (%dk) held, %dk in use\n",
+        total_pages, (total_pages << PAGE_SHIFT) >> KB_SHIFT, total_used >> KB_SHIFT);
+}
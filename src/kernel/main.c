@@ -47,9 +47,12 @@
 #include <kernel/termios.h>
 #include <sys/ioctl.h>
 
+extern void init_cpu_ops(void);
 extern void init_fs(void);
 extern void init_io(void);
+extern void init_irq(void);
 extern void init_mm(struct boot_info *);
+extern void init_trace(void);
 extern void init_tty(void);
 
 #if TEST_BUILD
@@ -81,6 +84,9 @@ __fastcall void kmain(struct boot_info **info)
 
     print_boot_info(boot_info);
 
+    init_cpu_ops();
+    init_irq();
+    init_trace();
     init_mm(boot_info);
 #if PRINT_PAGE_MAP
     print_page_mappings();
@@ -171,20 +177,20 @@ int main(void)
     int fd = RIF(open("/dev/ttyS2", O_RDWR | O_NONBLOCK));
 
     // set serial TTY termios flags
-    //  disable local echo, enable flow control
+    //  disable line editing and local echo, enable flow control
     struct termios serial_tio;
     ioctl(fd, TCGETS, &serial_tio);
     serial_tio.c_iflag |= (ICRNL | IXON | IXOFF);
     serial_tio.c_oflag |= (OPOST | ONLCR);
     serial_tio.c_cflag |= (CRTSCTS);
-    serial_tio.c_lflag &= ~(ECHO | ECHOCTL);
+    serial_tio.c_lflag &= ~(ICANON | ECHO | ECHOCTL);
     ioctl(fd, TCSETS, &serial_tio);
 
-    // set stdin termios flags to disable local echo
+    // set stdin termios flags to disable line editing and local echo
     struct termios stdin_tio, orig_tio;
     ioctl(STDIN_FILENO, TCGETS, &orig_tio);
     stdin_tio = orig_tio;
-    stdin_tio.c_lflag &= ~(ECHO | ECHOCTL);
+    stdin_tio.c_lflag &= ~(ICANON | ECHO | ECHOCTL);
     ioctl(STDIN_FILENO, TCSETS, &stdin_tio);
 
     // set stdin to nonblocking
@@ -251,6 +257,15 @@ int main(void)
         stats.n_parity, stats.n_framing, stats.n_timeout, stats.n_break);
     printf("  cts:%d dsr:%d ri:%d dcd:%d\n",
         stats.n_cts, stats.n_dsr, stats.n_ring, stats.n_dcd);
+    printf("  in:%d rxmax:%d drop:%d condrop:%d\n",
+        stats.n_intr, stats.n_rx_max, stats.n_rx_dropped, stats.n_con_dropped);
+
+    // show UART info
+    struct serial_info info;
+    ioctl(fd, TIOCGSERIAL, &info);
+    printf("serial info:\n");
+    printf("  type:%d port:%Xh div:%d fifo:%d trig:%d\n",
+        info.type, info.port, info.baud_divisor, info.fifo_size, info.rx_trig);
 
     // close 'er out -- TODO: need to make this actually work
     close(fd);
@@ -27,17 +27,21 @@
 #include <i386/bitops.h>
 #include <i386/boot.h>
 #include <i386/cpu.h>
+#include <i386/dispatch.h>
 #include <i386/paging.h>
 #include <kernel/config.h>
 #include <kernel/list.h>
 #include <kernel/mm.h>
 #include <kernel/ohwes.h>
 #include <kernel/pool.h>
+#include <kernel/trace.h>
 
-// struct free_page {
-//     struct free_page *next;
-//     uint16_t pfn;
-// } __pack;
+// per-page descriptor; links the first page of a free block into the free
+// list for the block's order, remembers the order of an allocated block
+struct page {
+    list_t list;
+    int order;
+};
 
 struct zone {
     const char *name;
@@ -46,8 +50,8 @@ struct zone {
     size_t mem_size_pages;
     size_t buddy_size_pages;
 
-    // allocable physical memory address range
-    //  TODO: eventually a list of ranges
+    // allocable physical memory address range; holes in between usable
+    // regions are never released to the free lists
     uintptr_t mem_start;            // start of allocable physical memory
     uintptr_t mem_end;              // end (limit) of allocable physical memory
 
@@ -56,18 +60,48 @@ struct zone {
     uintptr_t alloc_end;            // end address visible to buddy allocator
 
     int bitmap_size;                // size of bitmap at highest order, in bits
-    char *bitmap[MAX_ORDER+1];      // per-order bitmap, DWORD-aligned
+    char *bitmap[MAX_ORDER+1];      // per-order bitmap, DWORD-aligned; bit set if block is on free list
+
+    list_t free_list[MAX_ORDER+1];  // per-order list of free blocks
+    size_t nr_free[MAX_ORDER+1];    // number of blocks on each free list
+    struct page *pages;             // page descriptors for the buddy range
 };
 
 static struct zone _zones[NR_ZONES];
 static struct acpi_mmap_entry _phys_mmap[64];
 
+// reserve of pre-zeroed single pages for ALLOC_ZERO; these are off the free
+// lists, linked through their page descriptors
+static list_t _zero_list;
+static struct zero_page_stats _zero_stats;
+
+// per-order caches of recently freed small blocks, most recent first; these
+// are off the free lists too
+static list_t _hot_list[NR_HOT_ORDERS];
+static struct hot_cache_stats _hot_stats;
+
+// page tables set aside for mapping memory before the page allocator is up
+static uintptr_t _pgtbl_reserve;        // next reserved page table
+static uintptr_t _pgtbl_reserve_end;    // end of reserved page tables
+
 static void check_memory(void);
 static void print_kernel_sections(void);
 
 static void init_phys_mmap(struct boot_info *boot);
 static void init_phys_mmap_legacy(struct boot_info *boot);
 static void init_zones(void);
+static void release_range(struct zone *zone, uintptr_t start, uintptr_t end);
+
+static void add_free_block(struct zone *zone, int index, int order);
+static void remove_free_block(struct zone *zone, int index, int order);
+static void free_block(struct zone *zone, int index, int order);
+static void * alloc_block(struct zone *zone, int order);
+static void * take_zero_page(struct zone *zone);
+static void * take_hot_block(struct zone *zone, int order);
+static void put_hot_block(struct zone *zone, struct page *page, int order);
+static void reserve_zero_page(struct zone *zone, struct page *page);
+static int drain_caches(struct zone *zone);
+static void * page_to_addr(struct zone *zone, struct page *page);
 
 void init_mm(struct boot_info *boot)
 {
@@ -198,22 +232,63 @@ static void init_zones(void)
     struct zone *zone = &_zones[ZONE_NORMAL];
     zone->name = STRINGIFY(ZONE_NORMAL);
 
-    // determine the end of the first contiguous physical memory region above 1M
-    //  TODO: expand this; include other regions, or define a max-sized region
+    // the zone spans from the end of the kernel to the top of the highest
+    // usable region above 1M that fits in the kernel's direct mapping
+    uint64_t top = 0;
     struct acpi_mmap_entry *e;
     for (e = _phys_mmap; mmap_valid(e); e++) {
-        if (e->base >= (1 * MB)) {
-            break;
+        if (mmap_usable(e) && e->base >= (1 * MB)) {
+            top = max(top, e->base + e->length);
         }
     }
-    if (!mmap_valid(e)) {
-        panic("what?? could not locate contiguous memory region above 1M");
+    if (top == 0) {
+        panic("what?? could not locate usable memory region above 1M");
     }
+    if (top > MAX_LOWMEM) {
+        warn("mem: ignoring %dM of memory above %dM\n",
+            (int) ((top - MAX_LOWMEM) >> MB_SHIFT), MAX_LOWMEM >> MB_SHIFT);
+        top = MAX_LOWMEM;
+    }
+    top &= PAGE_MASK;
 
     // allocable physical address range
     zone->mem_start = PHYSICAL_ADDR(PAGE_ALIGN(__kernel_end));
-    zone->mem_end = PHYSICAL_ADDR(e->base + e->length - 1);
-    zone->mem_size_pages = PAGE_ALIGN(zone->mem_end+1 - zone->mem_start) >> PAGE_SHIFT;
+    zone->mem_end = top - 1;
+
+    // the boot page table covers the first 4M, so we can extend the mapping
+    // that far without needing any new page tables...
+    pgflags_t flags = _PAGE_RW | _PAGE_PRESENT;
+    uintptr_t boot_top = min((uintptr_t) (4*MB), (uintptr_t) top);
+    update_page_mappings(KERNEL_ADDR(zone->mem_start), zone->mem_start,
+        (boot_top - zone->mem_start) >> PAGE_SHIFT, flags);
+
+    // ...then set aside enough page tables to map the rest of the zone; with
+    // large pages we only need them for a partial 4M chunk at the top
+    bool large = enable_large_pages();
+    if (large) {
+        flags |= _PAGE_LARGE;
+    }
+    int nr_pgtbl = 0;
+    pde_t *pgdir = (pde_t *) get_pgdir();
+    for (uintptr_t pa = zone->mem_start; pa < top; pa = (pa + PGDIR_SIZE) & PGDIR_MASK) {
+        pde_t *pde = (pde_t *) KERNEL_ADDR(pde_offset(pgdir, KERNEL_ADDR(pa)));
+        bool whole = aligned(pa, PGDIR_SIZE) && pa + PGDIR_SIZE <= top;
+        if (!pde_present(*pde) && !(large && whole)) {
+            nr_pgtbl++;
+        }
+    }
+    _pgtbl_reserve = zone->mem_start;
+    _pgtbl_reserve_end = _pgtbl_reserve + (nr_pgtbl << PAGE_SHIFT);
+    if (_pgtbl_reserve_end > boot_top) {
+        panic("mem: no room for %d page tables below %dM!", nr_pgtbl, boot_top >> MB_SHIFT);
+    }
+    zone->mem_start = _pgtbl_reserve_end;
+
+    if (top > boot_top) {
+        update_page_mappings(KERNEL_ADDR(boot_top), boot_top,
+            (top - boot_top) >> PAGE_SHIFT, flags);
+    }
+    assert(_pgtbl_reserve == _pgtbl_reserve_end);
 
     // address range visible to buddy allocator
     zone->alloc_start = (zone->mem_start & ~(MAX_ORDER_SIZE - 1));
@@ -223,7 +298,7 @@ static void init_zones(void)
     assert(zone->alloc_start <= zone->mem_start);
     assert(zone->alloc_end >= zone->mem_end);
 
-    // set up a bitmap for keeping track of physical page alloc status
+    // set up a bitmap for keeping track of buddy state
     char *bitmap = (char *) KERNEL_ADDR(zone->mem_start);
 
     // figure out bitmap layout for each order
@@ -239,78 +314,149 @@ static void init_zones(void)
     }
     assert(aligned(total_num_bits, 32));
 
-    // now we know the size of the bitmap, initialize it!
-    size_t bitmap_size_pages = PAGE_ALIGN(div_ceil(total_num_bits, 8)) >> PAGE_SHIFT;
-    memset(bitmap, 0xFF, bitmap_size_pages << PAGE_SHIFT);
-
-    // adjust allocable memory range to account for bitmap
-    zone->mem_start += bitmap_size_pages << PAGE_SHIFT;
-    zone->mem_size_pages -= bitmap_size_pages;
-    zone->free_pages = zone->mem_size_pages;
+    // page descriptors live right after the bitmap
+    size_t bitmap_size_bytes = total_num_bits >> 3;
+    size_t pages_size_bytes = zone->buddy_size_pages * sizeof(struct page);
+    zone->pages = (struct page *) (bitmap + bitmap_size_bytes);
+
+    // now we know the size of the metadata, initialize it! all blocks start
+    // out allocated; the usable ones are handed to the free lists below
+    size_t meta_size_pages = PAGE_ALIGN(bitmap_size_bytes + pages_size_bytes) >> PAGE_SHIFT;
+    zeromem(bitmap, meta_size_pages << PAGE_SHIFT);
+    for (int i = 0; i <= MAX_ORDER; i++) {
+        list_init(&zone->free_list[i]);
+        zone->nr_free[i] = 0;
+    }
 
-    // now, clear out the bits that represent unreachable regions;
-    for (int i = MAX_ORDER; i >= 0; i--) {
-        const uint32_t order_size = (1 << (i+PAGE_SHIFT));
-        const uint32_t bitmap_size = (zone->bitmap_size << (MAX_ORDER-i));
+    // adjust allocable memory range to account for metadata
+    zone->mem_start += meta_size_pages << PAGE_SHIFT;
+    zone->free_pages = 0;
 
-        for (uint32_t lo = zone->alloc_start, bit = 0;
-                lo < (uint32_t) zone->mem_start;
-                lo += order_size, bit++) {
-            clear_bit(zone->bitmap[i], bit);
+    // release every usable region that falls inside the zone
+    for (e = _phys_mmap; mmap_valid(e); e++) {
+        if (!mmap_usable(e) || e->base + e->length <= zone->mem_start || e->base >= top) {
+            continue;
         }
-
-        for (uint32_t hi = zone->alloc_end+1, bit = bitmap_size - 1;
-                hi > (uint32_t) (zone->mem_end+1);
-                hi -= order_size, bit--) {
-            clear_bit(zone->bitmap[i], bit);
+        uintptr_t start = PAGE_ALIGN(max(e->base, (uint64_t) zone->mem_start));
+        uintptr_t end = min(e->base + e->length, top) & PAGE_MASK;
+        if (start < end) {
+            release_range(zone, start, end);
         }
     }
+    zone->mem_size_pages = zone->free_pages;
+
+    // stock up on zeroed pages while we're not in anyone's way
+    list_init(&_zero_list);
+    for (int o = 0; o < NR_HOT_ORDERS; o++) {
+        list_init(&_hot_list[o]);
+    }
+    refill_zero_pages(NR_ZERO_PAGES);
 
     kprint("mem: %s: mem_start=%08X mem_end=%08X mem_size_pages=%d\n",
         zone->name, zone->mem_start, zone->mem_end, zone->mem_size_pages);
-    kprint("mem: %s: bitmap=%08X size_pages=%d\n",
-        zone->name, bitmap, bitmap_size_pages);
+    kprint("mem: %s: bitmap=%08X pages=%08X size_pages=%d pgtbls=%d large_pages=%d\n",
+        zone->name, bitmap, zone->pages, meta_size_pages, nr_pgtbl, large);
+}
 
-    // ensure pages are mapped to speed up allocation time
-    uintptr_t top = min((4*MB), zone->mem_end+1); // TODO: temp workaround for update_page_mappings 4M limit...
-    size_t size_pages = (top - zone->mem_start) >> PAGE_SHIFT;
-    warn("mem: mapping only up to 4M until multiple PDEs are supported!\n");
-    pgflags_t flags = _PAGE_RW | _PAGE_PRESENT;
-    update_page_mappings(KERNEL_ADDR(zone->mem_start), zone->mem_start, size_pages, flags);
+// carve a physical address range into the largest naturally-aligned blocks
+// that fit and release them to the free lists
+static void release_range(struct zone *zone, uintptr_t start, uintptr_t end)
+{
+    uintptr_t pa = start;
+    while (pa < end) {
+        int order = MAX_ORDER;
+        while (order > 0 &&
+            (!aligned(pa - zone->alloc_start, get_order_size(order)) ||
+             pa + get_order_size(order) > end)) {
+            order--;
+        }
 
-    // TODO: could calculate how many page tables are needed to alloc all of
-    // "Normal" memory, then stuff them before the bitmap too...
+        int index = (pa - zone->alloc_start) >> (order+PAGE_SHIFT);
+        free_block(zone, index, order);
+        zone->free_pages += (1 << order);
+        pa += get_order_size(order);
+    }
 }
 
-void * alloc_pages(int flags, int order)
+void * alloc_pgtbl(void)
 {
-    if (order < 0 || order > MAX_ORDER) {
-        return NULL;
+    void *pgtbl;
+
+    if (_pgtbl_reserve < _pgtbl_reserve_end) {
+        pgtbl = (void *) KERNEL_ADDR(_pgtbl_reserve);
+        _pgtbl_reserve += PAGE_SIZE;
+        g_cpu_ops.zero_page(pgtbl);
+        return pgtbl;
     }
 
-    // TODO: validate flags
+    if (_zones[ZONE_NORMAL].pages == NULL) {
+        return NULL;    // page allocator not up yet
+    }
 
-    // locate next free region at current order
-    struct zone *zone = &_zones[ZONE_NORMAL];
-    size_t bitmap_size = (zone->bitmap_size << (MAX_ORDER-order));
-    size_t bitmap_size_bytes = div_ceil(bitmap_size, 32) << 2;  // DWORD-aligned size
-    int index = bit_scan_forward(zone->bitmap[order], bitmap_size_bytes);
-    if (index < 0 || index >= bitmap_size) {
-        return NULL;
+    return alloc_pages(ALLOC_ZERO, 0);
+}
+
+static void add_free_block(struct zone *zone, int index, int order)
+{
+    struct page *page = &zone->pages[index << order];
+
+    set_bit(zone->bitmap[order], index);
+    list_add_tail(&zone->free_list[order], &page->list);   // LIFO; keep it warm
+    zone->nr_free[order]++;
+}
+
+static void remove_free_block(struct zone *zone, int index, int order)
+{
+    struct page *page = &zone->pages[index << order];
+
+    clear_bit(zone->bitmap[order], index);
+    list_remove(&page->list);
+    zone->nr_free[order]--;
+}
+
+static void free_block(struct zone *zone, int index, int order)
+{
+    // coalesce with the buddy for as long as the buddy is also free
+    while (order < MAX_ORDER) {
+        int buddy = index ^ 1;
+        if (!test_bit(zone->bitmap[order], buddy)) {
+            break;
+        }
+        remove_free_block(zone, buddy, order);
+        index >>= 1;
+        order++;
     }
 
-    // mark the current- and lower-order chunks used
-    for (int o = order, i = index, c = 1; o >= 0; o--, i <<= 1, c <<= 1) {
-        for (int n = 0; n < c; n++) {
-            clear_bit(zone->bitmap[o], i + n);  // TODO: need a fast way to clear a range of bits...
+    add_free_block(zone, index, order);
+}
+
+// take a block off the free lists, splitting a larger one if needed
+static void * alloc_block(struct zone *zone, int order)
+{
+    // locate the smallest free block that will satisfy the request
+    int o;
+    for (o = order; o <= MAX_ORDER; o++) {
+        if (!list_empty(&zone->free_list[o])) {
+            break;
         }
     }
+    if (o > MAX_ORDER) {
+        return NULL;
+    }
 
-    // mark the higher-order chunks used
-    for (int o = order + 1, i = index >> 1; o <= MAX_ORDER; o++, i >>= 1) {
-        clear_bit(zone->bitmap[o], i);
+    struct page *page = list_item(zone->free_list[o].next, struct page, list);
+    int index = (page - zone->pages) >> o;
+    remove_free_block(zone, index, o);
+
+    // split it down to size, returning the upper halves to the free lists
+    while (o > order) {
+        o--;
+        index <<= 1;
+        add_free_block(zone, index + 1, o);
     }
 
+    zone->pages[index << order].order = order;
+
     // calculate alloc address
     const uint32_t order_size = (1 << (order+PAGE_SHIFT));
     uint32_t addr = zone->alloc_start + (index * order_size);
@@ -320,14 +466,227 @@ void * alloc_pages(int flags, int order)
         panic("mem: %s: alloc out of bounds!!", zone->name);
     }
 
-    void *kern_addr = (void *) KERNEL_ADDR(addr);
-
     zone->free_pages -= (order_size >> PAGE_SHIFT);
+    return (void *) KERNEL_ADDR(addr);
+}
+
+static void * take_zero_page(struct zone *zone)
+{
+    if (list_empty(&_zero_list)) {
+        return NULL;
+    }
+
+    struct page *page = list_item(_zero_list.next, struct page, list);
+    list_remove(&page->list);
+    page->order = 0;
+    _zero_stats.nr_reserved--;
+
+    return page_to_addr(zone, page);
+}
+
+static void * take_hot_block(struct zone *zone, int order)
+{
+    list_t *hot = &_hot_list[order];
+
+    if (list_empty(hot)) {
+        // refill a batch at a time so we don't hit the free lists every time
+        for (int i = 0; i < HOT_CACHE_BATCH; i++) {
+            void *addr = alloc_block(zone, order);
+            if (addr == NULL) {
+                break;
+            }
+            struct page *page = &zone->pages[(PHYSICAL_ADDR(addr) - zone->alloc_start) >> PAGE_SHIFT];
+            page->order = -1;   // not allocated
+            list_add(hot, &page->list);
+            _hot_stats.nr_cached[order]++;
+        }
+        if (list_empty(hot)) {
+            return NULL;
+        }
+        _hot_stats.nr_refills++;
+    }
+    else {
+        _hot_stats.nr_hits++;
+    }
+
+    // most recently freed block first, it's the most likely to be in cache
+    struct page *page = list_item(hot->next, struct page, list);
+    list_remove(&page->list);
+    page->order = order;
+    _hot_stats.nr_cached[order]--;
+
+    return page_to_addr(zone, page);
+}
+
+static void put_hot_block(struct zone *zone, struct page *page, int order)
+{
+    list_t *hot = &_hot_list[order];
+
+    page->order = -1;
+    list_add_tail(hot, &page->list);
+    _hot_stats.nr_cached[order]++;
+
+    // frees mostly stop here now, so if the zeroed page reserve has run dry,
+    // restock it with a few of the coldest cached pages
+    if (order == 0 && _zero_stats.nr_reserved == 0) {
+        for (int i = 0; i < ZERO_REFILL_BUDGET; i++) {
+            page = list_item(hot->prev, struct page, list);
+            list_remove(&page->list);
+            _hot_stats.nr_cached[order]--;
+            reserve_zero_page(zone, page);
+            if (list_empty(hot)) {
+                break;
+            }
+        }
+    }
+
+    if (_hot_stats.nr_cached[order] <= HOT_CACHE_HIGH) {
+        return;
+    }
+
+    // too many; give the coldest batch back
+    for (int i = 0; i < HOT_CACHE_BATCH; i++) {
+        page = list_item(hot->prev, struct page, list);
+        list_remove(&page->list);
+        _hot_stats.nr_cached[order]--;
+
+        // top up the zeroed page reserve before giving pages back
+        if (order == 0 && _zero_stats.nr_reserved < NR_ZERO_PAGES) {
+            reserve_zero_page(zone, page);
+            continue;
+        }
+
+        free_block(zone, (page - zone->pages) >> order, order);
+        zone->free_pages += (1 << order);
+    }
+    _hot_stats.nr_drains++;
+}
+
+// zero a free page and put it in the reserve
+static void reserve_zero_page(struct zone *zone, struct page *page)
+{
+    g_cpu_ops.zero_page(page_to_addr(zone, page));
+    page->order = -1;   // not allocated
+    list_add_tail(&_zero_list, &page->list);
+    _zero_stats.nr_reserved++;
+    _zero_stats.nr_refilled++;
+}
+
+// give every cached block back to the free lists so it can coalesce;
+//  returns the number of blocks given back
+static int drain_caches(struct zone *zone)
+{
+    struct page *page;
+    int count = 0;
+
+    for (int o = 0; o < NR_HOT_ORDERS; o++) {
+        while (!list_empty(&_hot_list[o])) {
+            page = list_item(_hot_list[o].next, struct page, list);
+            list_remove(&page->list);
+            _hot_stats.nr_cached[o]--;
+            free_block(zone, (page - zone->pages) >> o, o);
+            zone->free_pages += (1 << o);
+            count++;
+        }
+    }
+
+    while (!list_empty(&_zero_list)) {
+        page = list_item(_zero_list.next, struct page, list);
+        list_remove(&page->list);
+        _zero_stats.nr_reserved--;
+        free_block(zone, page - zone->pages, 0);
+        zone->free_pages++;
+        count++;
+    }
+
+    return count;
+}
+
+static void * page_to_addr(struct zone *zone, struct page *page)
+{
+    return (void *) KERNEL_ADDR(zone->alloc_start + ((page - zone->pages) << PAGE_SHIFT));
+}
+
+int refill_zero_pages(int budget)
+{
+    struct zone *zone = &_zones[ZONE_NORMAL];
+    int count = 0;
+
+    while (count < budget && _zero_stats.nr_reserved < NR_ZERO_PAGES) {
+        void *addr = alloc_block(zone, 0);
+        if (addr == NULL) {
+            break;
+        }
+        g_cpu_ops.zero_page(addr);
+
+        struct page *page = &zone->pages[(PHYSICAL_ADDR(addr) - zone->alloc_start) >> PAGE_SHIFT];
+        page->order = -1;   // not allocated
+        list_add_tail(&_zero_list, &page->list);
+        _zero_stats.nr_reserved++;
+        _zero_stats.nr_refilled++;
+        count++;
+    }
+
+    return count;
+}
+
+void * alloc_pages(int flags, int order)
+{
+    if (order < 0 || order > MAX_ORDER) {
+        return NULL;
+    }
+
+    // TODO: validate flags
+
+    struct zone *zone = &_zones[ZONE_NORMAL];
+    const uint32_t order_size = (1 << (order+PAGE_SHIFT));
+    void *kern_addr;
+
+    // single zeroed pages come straight out of the reserve
+    if (order == 0 && (flags & ALLOC_ZERO)) {
+        kern_addr = take_zero_page(zone);
+        if (kern_addr != NULL) {
+            _zero_stats.nr_hits++;
+            return kern_addr;
+        }
+    }
+
+    for (int retry = 0; ; retry++) {
+        if (order < NR_HOT_ORDERS) {
+            kern_addr = take_hot_block(zone, order);
+        }
+        else {
+            kern_addr = alloc_block(zone, order);
+        }
+        if (kern_addr == NULL && order == 0) {
+            kern_addr = take_zero_page(zone);   // last resort, it's free memory
+            if (kern_addr != NULL) {
+                flags &= ~ALLOC_ZERO;
+            }
+        }
+        if (kern_addr != NULL) {
+            break;
+        }
+
+        // the memory we need may be sitting in the caches in pieces; merge
+        // it back into the free lists and try once more
+        if (retry > 0 || drain_caches(zone) == 0) {
+            return NULL;
+        }
+    }
+
+#if PRINT_PAGE_ALLOC
     kprint("mem: %s: alloc %08X-%08X order %d; %d pages left\n",
         zone->name, kern_addr, kern_addr+order_size-1, order, zone->free_pages);
+#endif
+    trace("mem: alloc %08X order %d flags %Xh from %pS",
+        kern_addr, order, flags, __builtin_return_address(0));
 
     if (flags & ALLOC_ZERO) {
-        zeromem(kern_addr, order_size);
+        for (uint32_t off = 0; off < order_size; off += PAGE_SIZE) {
+            g_cpu_ops.zero_page(kern_addr + off);
+        }
+        _zero_stats.nr_misses += (1 << order);
     }
 
     return kern_addr;
@@ -350,27 +709,157 @@ void free_pages(void *addr, int order)
         return;
     }
 
+    // already free if this block or any block containing it is on a free list,
+    // or if it's sitting in a hot cache or the zeroed page reserve
     int index = (phys_addr - zone->alloc_start) >> (order+PAGE_SHIFT);
+    struct page *page = &zone->pages[index << order];
+    bool already_free = (page->order < 0);
+    for (int o = order, i = index; o <= MAX_ORDER; o++, i >>= 1) {
+        already_free |= test_bit(zone->bitmap[o], i);
+    }
+    if (already_free) {
+        warn("mem: %s: double free of %08X order %d!\n", zone->name, addr, order);
+        return;
+    }
+
+#if PRINT_PAGE_ALLOC
+    kprint("mem: %s: free %08X-%08X order %d; %d pages left\n",
+        zone->name, addr, addr+order_size-1, order, zone->free_pages);
+#endif
+    trace("mem: free %08X order %d from %pS",
+        addr, order, __builtin_return_address(0));
+
+    if (order < NR_HOT_ORDERS) {
+        put_hot_block(zone, page, order);
+        return;
+    }
+
+    free_block(zone, index, order);
+    zone->free_pages += (order_size >> PAGE_SHIFT);
+}
+
+int get_block_order(void *addr)
+{
+    struct zone *zone = &_zones[ZONE_NORMAL];
+    uintptr_t phys_addr = PHYSICAL_ADDR(addr);
+
+    if (phys_addr < zone->mem_start || phys_addr > zone->mem_end) {
+        return -1;
+    }
+    if (!aligned(phys_addr, PAGE_SIZE)) {
+        return -1;
+    }
 
-    // free the current- and lower-order chunks
+    return zone->pages[(phys_addr - zone->alloc_start) >> PAGE_SHIFT].order;
+}
+
+int verify_free_lists(void)
+{
+    struct zone *zone = &_zones[ZONE_NORMAL];
+    size_t total_pages = 0;
+
+    for (int o = 0; o <= MAX_ORDER; o++) {
+        size_t bitmap_size = (zone->bitmap_size << (MAX_ORDER-o));
+        size_t count = 0;
+
+        // every block on the free list must be aligned, marked in the bitmap,
+        // and must not have a free buddy (or it should have been merged)
+        for (list_iterator(n, &zone->free_list[o])) {
+            int pfn = list_item(n, struct page, list) - zone->pages;
+            int index = pfn >> o;
+            if (!aligned(pfn, (1 << o)) || !test_bit(zone->bitmap[o], index)) {
+                return -1;
+            }
+            if (o < MAX_ORDER && test_bit(zone->bitmap[o], index ^ 1)) {
+                return -1;
+            }
+            count++;
+        }
 
-    for (int o = order, i = index, c = 1; o >= 0; o--, i <<= 1, c <<= 1) {
-        for (int n = 0; n < c; n++) {
-            set_bit(zone->bitmap[o], i + n);
+        // ...and every bit set in the bitmap must be on the free list
+        size_t num_set = 0;
+        for (int i = find_next_set_bit(zone->bitmap[o], bitmap_size, 0); i >= 0;
+                i = find_next_set_bit(zone->bitmap[o], bitmap_size, i + 1)) {
+            num_set++;
+        }
+        if (num_set != count || count != zone->nr_free[o]) {
+            return -1;
         }
+
+        total_pages += (count << o);
     }
 
-    for (int o = order, i = index; o < MAX_ORDER; o++, i >>= 1) {
-        int neighbor = (i % 2) ? i-1 : i+1;
-        if (0 == test_bit(zone->bitmap[o], neighbor)) {
-            break;
+    if (total_pages != zone->free_pages) {
+        return -1;
+    }
+
+    // pages in the zeroed reserve are free too, just not on the lists
+    size_t nr_zeroed = 0;
+    for (list_iterator(n, &_zero_list)) {
+        struct page *page = list_item(n, struct page, list);
+        int pfn = page - zone->pages;
+        if (page->order != -1 || test_bit(zone->bitmap[0], pfn)) {
+            return -1;
         }
-        set_bit(zone->bitmap[o + 1], i >> 1);
+        nr_zeroed++;
+    }
+    if (nr_zeroed != _zero_stats.nr_reserved) {
+        return -1;
     }
 
-    zone->free_pages += (order_size >> PAGE_SHIFT);
-    kprint("mem: %s: free %08X-%08X order %d; %d pages left\n",
-        zone->name, addr, addr+order_size-1, order, zone->free_pages);
+    // so are the blocks in the hot caches
+    size_t nr_hot_pages = 0;
+    for (int o = 0; o < NR_HOT_ORDERS; o++) {
+        size_t count = 0;
+        for (list_iterator(n, &_hot_list[o])) {
+            struct page *page = list_item(n, struct page, list);
+            int pfn = page - zone->pages;
+            if (page->order != -1 || !aligned(pfn, (1 << o)) || test_bit(zone->bitmap[o], pfn >> o)) {
+                return -1;
+            }
+            count++;
+        }
+        if (count != _hot_stats.nr_cached[o]) {
+            return -1;
+        }
+        nr_hot_pages += (count << o);
+    }
+
+    return total_pages + nr_zeroed + nr_hot_pages;
+}
+
+void get_hot_cache_stats(struct hot_cache_stats *stats)
+{
+    *stats = _hot_stats;
+}
+
+void get_zero_page_stats(struct zero_page_stats *stats)
+{
+    *stats = _zero_stats;
+}
+
+void print_mm_stats(void)
+{
+    struct zone *zone = &_zones[ZONE_NORMAL];
+
+    size_t nr_hot_pages = 0;
+    for (int o = 0; o < NR_HOT_ORDERS; o++) {
+        nr_hot_pages += (_hot_stats.nr_cached[o] << o);
+    }
+
+    kprint("mem: %s: %d of %d pages free\n", zone->name,
+        zone->free_pages + nr_hot_pages + _zero_stats.nr_reserved, zone->mem_size_pages);
+    kprint("mem: free blocks by order:");
+    for (int o = 0; o <= MAX_ORDER; o++) {
+        kprint(" %d", zone->nr_free[o]);
+    }
+    kprint("\n");
+    kprint("mem: zero pages: %d/%d reserved, %d hits, %d misses, %d refilled\n",
+        _zero_stats.nr_reserved, NR_ZERO_PAGES, _zero_stats.nr_hits,
+        _zero_stats.nr_misses, _zero_stats.nr_refilled);
+    kprint("mem: hot cache: %d/%d blocks, %d hits, %d refills, %d drains\n",
+        _hot_stats.nr_cached[0], _hot_stats.nr_cached[1], _hot_stats.nr_hits,
+        _hot_stats.nr_refills, _hot_stats.nr_drains);
 }
 
 int get_order(size_t size)
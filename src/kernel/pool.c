@@ -24,19 +24,25 @@
 #include <kernel/mm.h>
 #include <kernel/ohwes.h>
 #include <kernel/pool.h>
+#include <kernel/trace.h>
 
-#define CHUNK_MAGIC     'nuhc'
+#define SLAB_MAGIC      'bals'
 
 #define pool_valid(p)   ((p) != INVALID_POOL && (p)->magic == POOL_MAGIC)
 
-// memory 'chunk' info for keeping track of pool item
-struct chunk {
-    uint32_t magic;     // identifier for chunk type
-    pool_t *pool;       // pool this item belongs to
-    list_t list;        // item chain in pool
-    void *data;         // item data
+// slab header, lives at the start of each slab allocation; items follow
+struct slab {
+    uint32_t magic;     // identifier for slab type
+    pool_t *pool;       // pool this slab belongs to
+    list_t list;        // link in pool partial or full list
+    void *free;         // first free slot; free slots link to the next
+    int count;          // number of slots allocated
 };
 
+#define SLAB_ITEM_OFFSET    align(sizeof(struct slab), sizeof(void *))
+#define slab_size(p)        (PAGE_SIZE << (p)->order)
+#define slab_base(p,item)   ((struct slab *) ((uintptr_t) (item) & ~(slab_size(p) - 1)))
+
 // global pool info
 struct pool_info {
     int order;          // order of master allocation
@@ -84,12 +90,51 @@ void destroy_pools()
 }
 #endif
 
-pool_t * pool_create(const char *name, size_t capacity, size_t size, int flags)
+static struct slab * grow_pool(struct pool *p)
+{
+    struct slab *slab;
+    char *item;
+
+    slab = (struct slab *) alloc_pages(0, p->order);
+    if (slab == NULL) {
+        return NULL;
+    }
+
+    slab->magic = SLAB_MAGIC;
+    slab->pool = p;
+    slab->count = 0;
+
+    // thread the free list through the slots themselves
+    item = (char *) slab + SLAB_ITEM_OFFSET;
+    slab->free = item;
+    for (int i = 0; i < p->per_slab - 1; i++, item += p->size) {
+        *((void **) item) = item + p->size;
+    }
+    *((void **) item) = NULL;
+
+    list_add_tail(&p->partial, &slab->list);
+
+    p->nr_slabs++;
+    p->capacity += p->per_slab;
+    return slab;
+}
+
+static void shrink_pool(struct pool *p, struct slab *slab)
+{
+    list_remove(&slab->list);
+    slab->magic = 0;
+    free_pages(slab, p->order);
+
+    p->nr_slabs--;
+    p->capacity -= p->per_slab;
+}
+
+pool_t * pool_create(const char *name, size_t size, int flags)
 {
-    // TODO: flags for alignment, zeroing, etc.
+    // TODO: flags for alignment, etc.
     (void) flags;
 
-    if (name == NULL || capacity <= 0 || size <= 0) {
+    if (name == NULL || size <= 0) {
         return INVALID_POOL;
     }
 
@@ -108,6 +153,17 @@ pool_t * pool_create(const char *name, size_t capacity, size_t size, int flags)
         return INVALID_POOL;
     }
 
+    // free slots hold the free list link, so they must fit a pointer
+    size = align(max(size, sizeof(void *)), sizeof(void *));
+
+    // pick the smallest slab that fits a reasonable number of items
+    int order = 0;
+    while ((PAGE_SIZE << order) - SLAB_ITEM_OFFSET < POOL_MIN_ITEMS * size) {
+        if (++order > MAX_ORDER) {
+            return INVALID_POOL;
+        }
+    }
+
     // lazy alloc master pool data
     if (g_poolinfo->alloc == NULL) {
         lazy_init_pools();
@@ -128,20 +184,8 @@ pool_t * pool_create(const char *name, size_t capacity, size_t size, int flags)
         return INVALID_POOL;
     }
 
-    // initialize pool
-    size_t size_bytes = capacity * (size + sizeof(struct chunk));
-    int order = get_order(size_bytes);
-    if (order < 0) {
-        return INVALID_POOL;
-    }
-    void *alloc = alloc_pages(ALLOC_ZERO, order);
-    if (alloc == NULL) {
-        warn("pool: create: not enough memory for pool size=%d capacity=%d!\n", size, capacity);
-        return INVALID_POOL;
-    }
-
     struct pool *p = list_item(g_poolinfo->free_list.next, struct pool, list);
-    if (p->magic != POOL_MAGIC || p->alloc != NULL) {
+    if (p->magic != POOL_MAGIC || p->nr_slabs != 0) {
         panic("pool: create: got corrupted pool data from master pool!");
         return INVALID_POOL;
     }
@@ -152,27 +196,20 @@ pool_t * pool_create(const char *name, size_t capacity, size_t size, int flags)
     g_poolinfo->count++;
     assert(g_poolinfo->count <= MAX_NR_POOLS);
 
-    p->order = order;
-    p->alloc = alloc;
     p->name = name;
     p->size = size;
-    p->capacity = capacity;
-
-    // now, we could put the chunk metadata before the allocation slot, or we
-    // could stuff it all somewhere else. one is more prone to corruption, while
-    // the other uses more data... hmmm, decisions decisions...
-
-    // let's put it at the start of the allocation, before the data
-    list_init(&p->free_list);
-    for (int i = 0; i < p->capacity; i++) {
-        struct chunk *chunk = ((struct chunk *) p->alloc) + i;
-        chunk->magic = CHUNK_MAGIC;
-        chunk->pool = INVALID_POOL;
-        list_add(&p->free_list, &chunk->list);
-    }
+    p->order = order;
+    p->per_slab = (slab_size(p) - SLAB_ITEM_OFFSET) / size;
+    p->capacity = 0;
+    p->count = 0;
+    p->nr_slabs = 0;
+    list_init(&p->partial);
+    list_init(&p->full);
+
+    // slabs are allocated on first use, so an idle pool costs nothing
 
-    kprint("pool: created '%s' size_pages=%d capacity=%d item_size=%d flags=%Xh\n",
-        name, get_order_size(p->order) >> PAGE_SHIFT, capacity, size, flags);
+    trace("pool: created '%s' slab_pages=%d items_per_slab=%d item_size=%d flags=%Xh",
+        name, slab_size(p) >> PAGE_SHIFT, p->per_slab, size, flags);
     return p;
 }
 
@@ -198,89 +235,133 @@ void pool_destroy(pool_t *pool)
         return; // invalid pool
     }
 
+    if (p->count != 0) {
+        warn("pool: %s: destroyed with %d items still allocated\n", p->name, p->count);
+    }
+
+    while (!list_empty(&p->partial)) {
+        shrink_pool(p, list_item(p->partial.next, struct slab, list));
+    }
+    while (!list_empty(&p->full)) {
+        shrink_pool(p, list_item(p->full.next, struct slab, list));
+    }
+    assert(p->nr_slabs == 0);
+    p->count = 0;
+
     name = p->name;
     p->name = NULL;
 
-    free_pages(p->alloc, p->order);
-    p->alloc = NULL;
-
     list_remove(&p->list);                      // remove from used list
     list_add(&g_poolinfo->free_list, &p->list); // add to free list
 
     g_poolinfo->count--;
     assert(g_poolinfo->count >= 0);
 
-    kprint("pool: destroyed '%s'\n", name);
+    trace("pool: destroyed '%s'", name);
 }
 
 void * pool_alloc(pool_t *pool, int flags)
 {
-    struct chunk *chunk;
-    int index;
-
-    (void) flags;   // TODO: flags
+    struct slab *slab;
+    void *item;
 
     if (!pool_valid(pool)) {
         return NULL;
     }
 
-    if (list_empty(&pool->free_list)) {
-        warn("pool: %s: alloc failed: pool is full!\n", pool->name);
-        return NULL;
+    if (list_empty(&pool->partial)) {
+        if (grow_pool(pool) == NULL) {
+            warn("pool: %s: alloc failed: out of memory!\n", pool->name);
+            return NULL;
+        }
     }
 
-    chunk = list_item(pool->free_list.next, struct chunk, list);
-    if (chunk->magic != CHUNK_MAGIC || chunk->pool != INVALID_POOL) {
-        panic("pool: %s: alloc failed: got corrupted chunk data", pool->name);
+    slab = list_item(pool->partial.next, struct slab, list);
+    if (slab->magic != SLAB_MAGIC || slab->pool != pool || slab->free == NULL) {
+        panic("pool: %s: alloc failed: got corrupted slab data", pool->name);
         return NULL;
     }
-    list_remove(&chunk->list);  // remove from free list
+
+    item = slab->free;
+    slab->free = *((void **) item);
+    slab->count++;
+    if (slab->free == NULL) {
+        list_remove(&slab->list);
+        list_add(&pool->full, &slab->list);
+    }
 
     pool->count++;
     assert(pool->count <= pool->capacity);
 
-    index = (chunk - (struct chunk *) pool->alloc);
-    assert(index >= 0);
-    assert(index < pool->capacity);
-
-    chunk->pool = pool;
-    chunk->data = pool->alloc + (pool->capacity * sizeof(struct chunk)) + (index * pool->size);
-    assert(chunk->data >= pool->alloc);
-    assert(chunk->data < pool->alloc + pool->capacity * (sizeof(struct chunk) + pool->size));
-    // TODO: consider flags for alignment and zeroing for chunk data
+    if (flags & ALLOC_ZERO) {
+        zeromem(item, pool->size);
+    }
 
-    return chunk->data;
+    return item;
 }
 
 void pool_free(pool_t *pool, const void *item)
 {
-    struct chunk *chunk;
-    int index;
+    struct slab *slab;
+    uintptr_t offset;
 
     if (!pool_valid(pool) || item == NULL) {
         return;
     }
 
-    const size_t chunk_area_size = pool->size * pool->capacity;
-    const uintptr_t chunk_base = (uintptr_t) pool->alloc + (pool->capacity * sizeof(struct chunk));
-    const uintptr_t item_addr = (uintptr_t) item;
-
-    if (item_addr < chunk_base || item_addr > chunk_base + chunk_area_size) {
+    slab = slab_base(pool, item);
+    offset = (uintptr_t) item - (uintptr_t) slab;
+    if (slab->magic != SLAB_MAGIC || slab->pool != pool
+        || offset < SLAB_ITEM_OFFSET
+        || (offset - SLAB_ITEM_OFFSET) % pool->size != 0
+        || (offset - SLAB_ITEM_OFFSET) / pool->size >= pool->per_slab) {
         warn("pool: %s: free failed: address invalid\n", pool->name);
         return;
     }
+    assert(slab->count > 0);
 
-    index = ((int) item - chunk_base) / pool->size;
-    chunk = (struct chunk *) pool->alloc + index;
-    assert(chunk->data == item);
-    if (chunk->data != item) {
-        panic("pool: %s: free failed: got corrupted chunk data", pool->name);
-        return;
+    if (slab->free == NULL) {
+        list_remove(&slab->list);               // no longer full
+        list_add_tail(&pool->partial, &slab->list);
     }
-
-    chunk->pool = INVALID_POOL;
-    list_add(&pool->free_list, &chunk->list);
+    *((void **) item) = slab->free;
+    slab->free = (void *) item;
+    slab->count--;
 
     pool->count--;
     assert(pool->count >= 0);
+
+    if (slab->count == 0) {
+        shrink_pool(pool, slab);                // give it back
+    }
+}
+
+pool_t * pool_of(const void *item)
+{
+    struct slab *slab;
+    uintptr_t index;
+
+    if (g_poolinfo->alloc == NULL || item == NULL) {
+        return INVALID_POOL;
+    }
+
+    // slabs are naturally aligned to their size, so try each slab size
+    for (int order = 0; order <= MAX_ORDER; order++) {
+        slab = (struct slab *) ((uintptr_t) item & ~((PAGE_SIZE << order) - 1));
+        if ((void *) slab == item || slab->magic != SLAB_MAGIC) {
+            continue;
+        }
+
+        // make sure the pool pointer is one of ours before following it
+        index = (uintptr_t) slab->pool - (uintptr_t) g_poolinfo->alloc;
+        if (index % sizeof(struct pool) != 0
+            || index / sizeof(struct pool) >= MAX_NR_POOLS) {
+            continue;
+        }
+        if (pool_valid(slab->pool) && slab->pool->order == order) {
+            return slab->pool;
+        }
+    }
+
+    return INVALID_POOL;
 }
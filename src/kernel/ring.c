@@ -21,13 +21,24 @@
 
 #include <assert.h>
 #include <string.h>
+#include <kernel/ohwes.h>
 #include <kernel/queue.h>
 
+// wrap an index that has moved at most one buffer length past the end
+static inline uint32_t ring_wrap(const struct ring *q, uint32_t i)
+{
+    if (q->mask) {
+        return i & q->mask;
+    }
+    return (i >= q->length) ? i - q->length : i;
+}
+
 void ring_init(struct ring *q, char *buf, size_t length)
 {
     memset(q, 0, sizeof(struct ring));
     q->ring = buf;
     q->length = length;
+    q->mask = _ring_mask(length);
 }
 
 bool ring_empty(const struct ring *q)
@@ -46,10 +57,8 @@ char ring_get(struct ring *q)
         return '\0';
     }
 
-    char c = q->ring[q->head++];
-    if (q->head >= q->length) {
-        q->head = 0;
-    }
+    char c = q->ring[q->head];
+    q->head = ring_wrap(q, q->head + 1);
 
     q->count--;
     return c;
@@ -61,15 +70,12 @@ bool ring_put(struct ring *q, char c)
         return false;
     }
 
-    q->ring[q->tail++] = c;
-    if (q->tail >= q->length) {
-        q->tail = 0;
-    }
+    q->ring[q->tail] = c;
+    q->tail = ring_wrap(q, q->tail + 1);
 
     q->count++;
     return true;
 }
-
 char ring_erase(struct ring *q)
 {
     if (ring_empty(q)) {
@@ -113,3 +119,175 @@ void ring_clear(struct ring *q)
 {
     q->head = q->tail = q->count = 0;
 }
+
+size_t ring_space(struct ring *q)
+{
+    return q->length - q->count;
+}
+
+size_t ring_write(struct ring *q, const char *buf, size_t n)
+{
+    size_t total, chunk;
+    char *ptr;
+
+    // at most two copies: up to the end of the buffer, then from the start
+    n = min(n, ring_space(q));
+    for (total = 0; total < n; total += chunk) {
+        chunk = min(n - total, ring_write_region(q, &ptr));
+        memcpy(ptr, buf + total, chunk);
+        ring_commit(q, chunk);
+    }
+
+    return total;
+}
+
+size_t ring_read(struct ring *q, char *buf, size_t n)
+{
+    size_t total, chunk;
+    const char *ptr;
+
+    n = min(n, q->count);
+    for (total = 0; total < n; total += chunk) {
+        chunk = min(n - total, ring_read_region(q, &ptr));
+        memcpy(buf + total, ptr, chunk);
+        ring_skip(q, chunk);
+    }
+
+    return total;
+}
+
+size_t ring_peek(const struct ring *q, char *buf, size_t n)
+{
+    size_t chunk;
+
+    n = min(n, q->count);
+    chunk = min(n, q->length - q->head);
+    memcpy(buf, &q->ring[q->head], chunk);
+    memcpy(buf + chunk, q->ring, n - chunk);
+
+    return n;
+}
+
+size_t ring_read_region(const struct ring *q, const char **ptr)
+{
+    *ptr = &q->ring[q->head];
+    return min(q->count, q->length - q->head);
+}
+
+void ring_skip(struct ring *q, size_t n)
+{
+    n = min(n, q->count);
+    q->head = ring_wrap(q, q->head + n);
+    q->count -= n;
+}
+
+size_t ring_write_region(const struct ring *q, char **ptr)
+{
+    *ptr = &q->ring[q->tail];
+    return min(q->length - q->count, q->length - q->tail);
+}
+
+void ring_commit(struct ring *q, size_t n)
+{
+    n = min(n, q->length - q->count);
+    q->tail = ring_wrap(q, q->tail + n);
+    q->count += n;
+}
+
+//
+// Single-producer, single-consumer ring. Each side reads the other side's
+// index once, then does its copying, then publishes its own index; the
+// barriers keep the compiler from moving the buffer accesses across the index
+// update. x86 doesn't reorder stores with other stores or loads with other
+// loads, so nothing stronger is needed.
+//
+
+void spsc_init(struct spsc_ring *q, char *buf, size_t len)
+{
+    assert(len != 0 && (len & (len - 1)) == 0);
+
+    q->ring = buf;
+    q->mask = len - 1;
+    q->head = 0;
+    q->tail = 0;
+}
+
+size_t spsc_count(const struct spsc_ring *q)
+{
+    return q->tail - q->head;
+}
+
+size_t spsc_space(const struct spsc_ring *q)
+{
+    return (q->mask + 1) - (q->tail - q->head);
+}
+
+bool spsc_put(struct spsc_ring *q, char c)
+{
+    uint32_t tail = q->tail;
+
+    if (tail - q->head > q->mask) {
+        return false;   // full
+    }
+
+    q->ring[tail & q->mask] = c;
+    barrier();          // char lands before the consumer can see it
+    q->tail = tail + 1;
+    return true;
+}
+
+size_t spsc_write(struct spsc_ring *q, const char *buf, size_t n)
+{
+    uint32_t tail = q->tail;
+    uint32_t start, chunk;
+
+    n = min(n, (q->mask + 1) - (tail - q->head));
+    barrier();          // no writing into slots until we've seen them freed
+
+    start = tail & q->mask;
+    chunk = min(n, (q->mask + 1) - start);
+    memcpy(&q->ring[start], buf, chunk);
+    memcpy(q->ring, buf + chunk, n - chunk);
+
+    barrier();
+    q->tail = tail + n;
+    return n;
+}
+
+bool spsc_get(struct spsc_ring *q, char *c)
+{
+    uint32_t head = q->head;
+
+    if (q->tail == head) {
+        return false;   // empty
+    }
+    barrier();          // don't read the char before seeing it was written
+
+    *c = q->ring[head & q->mask];
+    barrier();          // finish reading before the producer can reuse the slot
+    q->head = head + 1;
+    return true;
+}
+
+size_t spsc_read(struct spsc_ring *q, char *buf, size_t n)
+{
+    uint32_t head = q->head;
+    uint32_t start, chunk;
+
+    n = min(n, q->tail - head);
+    barrier();
+
+    start = head & q->mask;
+    chunk = min(n, (q->mask + 1) - start);
+    memcpy(buf, &q->ring[start], chunk);
+    memcpy(buf + chunk, q->ring, n - chunk);
+
+    barrier();
+    q->head = head + n;
+    return n;
+}
+
+void spsc_clear(struct spsc_ring *q)
+{
+    q->head = q->tail;
+}
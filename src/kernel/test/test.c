@@ -23,22 +23,36 @@
 #include <kernel/kernel.h>
 
 extern void test_bsf(void);
+extern void test_dispatch(void);
+extern void test_kmalloc(void);
 extern void test_list(void);
+extern void test_mm(void);
+extern void test_pgtbl(void);
 extern void test_pool(void);
 extern void test_printf(void);
 extern void test_ring(void);
 extern void test_string(void);
+extern void test_trace(void);
+extern void test_tty(void);
+extern void test_wait(void);
 
 void run_tests(void)
 {
     tprint(_YLW("running tests...\n"));
 
     test_string();
+    test_dispatch();
     test_printf();
     test_bsf();
     test_ring();
     test_list();
+    test_mm();
+    test_pgtbl();
+    test_kmalloc();
     test_pool();
+    test_trace();
+    test_tty();
+    test_wait();
 
     tprint(_GRN("all tests passed!\n"));
 }
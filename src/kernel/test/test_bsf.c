@@ -24,6 +24,8 @@
 #include <kernel/kernel.h>
 #include <kernel/ohwes.h>
 
+static void test_bit_range(void);
+
 void test_bsf(void)
 {
     DECLARE_TEST("bit scan forward");
@@ -46,4 +48,62 @@ void test_bsf(void)
     // msb == 1
     bits[7] = 0x80;
     VERIFY_IS_TRUE(bit_scan_forward(bits, sizeof(bits)) == 63);
+
+    test_bit_range();
+}
+
+static bool verify_range(uint32_t *bits, int size, int start, int count, int value)
+{
+    for (int i = 0; i < size; i++) {
+        int expected = (i >= start && i < start + count) ? value : !value;
+        if (!!test_bit(bits, i) != expected) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void test_bit_range(void)
+{
+    DECLARE_TEST("bit ranges");
+
+    uint32_t bits[6];
+    const int size = sizeof(bits) << 3;
+
+    // head only, head+tail, head+middle+tail, middle only, full
+    const int ranges[][2] = {
+        { 3, 5 }, { 0, 1 }, { 31, 1 }, { 30, 4 },
+        { 5, 100 }, { 32, 64 }, { 32, 65 }, { 0, size },
+    };
+
+    for (int i = 0; i < countof(ranges); i++) {
+        int start = ranges[i][0];
+        int count = ranges[i][1];
+
+        zeromem(bits, sizeof(bits));
+        set_bit_range(bits, start, count);
+        VERIFY_IS_TRUE(verify_range(bits, size, start, count, 1));
+        VERIFY_ARE_EQUAL(start, find_next_set_bit(bits, size, 0));
+        VERIFY_ARE_EQUAL(start + count - 1, find_next_set_bit(bits, size, start + count - 1));
+        VERIFY_ARE_EQUAL((start + count < size) ? start + count : -1,
+            find_next_zero_bit(bits, size, start));
+
+        memset(bits, 0xFF, sizeof(bits));
+        clear_bit_range(bits, start, count);
+        VERIFY_IS_TRUE(verify_range(bits, size, start, count, 0));
+        VERIFY_ARE_EQUAL(start, find_next_zero_bit(bits, size, 0));
+        VERIFY_ARE_EQUAL((start + count < size) ? start + count : -1,
+            find_next_set_bit(bits, size, start));
+    }
+
+    // empty range is a no-op
+    zeromem(bits, sizeof(bits));
+    set_bit_range(bits, 7, 0);
+    VERIFY_ARE_EQUAL(-1, find_next_set_bit(bits, size, 0));
+
+    // search stops at size, even if the bitstring has more bits
+    set_bit_range(bits, 40, 1);
+    VERIFY_ARE_EQUAL(-1, find_next_set_bit(bits, 40, 0));
+    VERIFY_ARE_EQUAL(40, find_next_set_bit(bits, 41, 0));
+    VERIFY_ARE_EQUAL(-1, find_next_set_bit(bits, size, size));
 }
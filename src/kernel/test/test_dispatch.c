@@ -0,0 +1,236 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: kernel/test/test_dispatch.c
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * =============================================================================
+ */
+
+#include <string.h>
+#include <test.h>
+#include <i386/cpu.h>
+#include <i386/dispatch.h>
+#include <i386/paging.h>
+#include <i386/x86.h>
+#include <kernel/ohwes.h>
+
+#define _BENCH_ITER     16
+
+static unsigned char _src[PAGE_SIZE * 2] __align(PAGE_SIZE);
+static unsigned char _dst[PAGE_SIZE * 2] __align(PAGE_SIZE);
+
+static void fill(unsigned char *buf, size_t count, int seed)
+{
+    for (size_t i = 0; i < count; i++) {
+        buf[i] = (unsigned char) (seed + i * 7);
+    }
+}
+
+static void check_memcpy(memcpy_fn fn)
+{
+    static const size_t sizes[] = { 0, 1, 3, 4, 63, 64, 65, 1000, PAGE_SIZE };
+
+    for (int i = 0; i < countof(sizes); i++) {
+        for (int off = 0; off < 4; off++) {
+            fill(_src, sizeof(_src), i);
+            memset(_dst, 0xCC, sizeof(_dst));
+            VERIFY_ARE_EQUAL(&_dst[off], fn(&_dst[off], &_src[3 - off], sizes[i]));
+            VERIFY_IS_ZERO(memcmp(&_dst[off], &_src[3 - off], sizes[i]));
+            VERIFY_ARE_EQUAL(0xCC, _dst[off + sizes[i]]);
+            if (off > 0) {
+                VERIFY_ARE_EQUAL(0xCC, _dst[off - 1]);
+            }
+        }
+    }
+}
+
+static void check_memset(memset_fn fn)
+{
+    static const size_t sizes[] = { 0, 1, 3, 4, 63, 64, 65, 1000, PAGE_SIZE };
+
+    for (int i = 0; i < countof(sizes); i++) {
+        for (int off = 0; off < 4; off++) {
+            memset(_dst, 0xCC, sizeof(_dst));
+            VERIFY_ARE_EQUAL(&_dst[off], fn(&_dst[off], 0x1A5, sizes[i]));
+            for (size_t k = 0; k < sizes[i]; k++) {
+                VERIFY_ARE_EQUAL(0xA5, _dst[off + k]);
+            }
+            VERIFY_ARE_EQUAL(0xCC, _dst[off + sizes[i]]);
+            if (off > 0) {
+                VERIFY_ARE_EQUAL(0xCC, _dst[off - 1]);
+            }
+        }
+    }
+}
+
+static void check_zero_page(zero_page_fn fn)
+{
+    memset(_dst, 0xCC, sizeof(_dst));
+    fn(&_dst[PAGE_SIZE]);
+    for (int k = 0; k < PAGE_SIZE; k++) {
+        VERIFY_ARE_EQUAL(0xCC, _dst[k]);
+        VERIFY_ARE_EQUAL(0, _dst[PAGE_SIZE + k]);
+    }
+}
+
+static void check_flush_pages(flush_pages_fn fn)
+{
+    uint32_t va[2] = { (uint32_t) &_dst[0], (uint32_t) &_dst[PAGE_SIZE] };
+
+    // the mappings don't change, so the pages must read back the same
+    memset(_dst, 0x5A, sizeof(_dst));
+    fn(va, 0);
+    fn(va, countof(va));
+    VERIFY_ARE_EQUAL(0x5A, _dst[0]);
+    VERIFY_ARE_EQUAL(0x5A, _dst[PAGE_SIZE]);
+}
+
+static void check_impl(enum cpu_op op, const struct cpu_impl *impl)
+{
+    switch (op) {
+        case CPU_OP_MEMCPY:
+            check_memcpy((memcpy_fn) impl->fn);
+            break;
+        case CPU_OP_MEMSET:
+            check_memset((memset_fn) impl->fn);
+            break;
+        case CPU_OP_ZERO_PAGE:
+            check_zero_page((zero_page_fn) impl->fn);
+            break;
+        case CPU_OP_FLUSH_PAGES:
+            check_flush_pages((flush_pages_fn) impl->fn);
+            break;
+        default:
+            break;
+    }
+}
+
+// get the function g_cpu_ops has plugged in for an op
+static void * selected_fn(enum cpu_op op)
+{
+    switch (op) {
+        case CPU_OP_MEMCPY:         return g_cpu_ops.memcpy;
+        case CPU_OP_MEMSET:         return g_cpu_ops.memset;
+        case CPU_OP_ZERO_PAGE:      return g_cpu_ops.zero_page;
+        case CPU_OP_FLUSH_PAGES:    return g_cpu_ops.flush_pages;
+        default:                    return NULL;
+    }
+}
+
+void test_dispatch_selection(void)
+{
+    int count;
+
+    for (int op = 0; op < NR_CPU_OPS; op++) {
+        const struct cpu_impl *impls = get_cpu_impls(op, &count);
+        VERIFY_IS_NOT_NULL(impls);
+        VERIFY_IS_TRUE(count > 0);
+
+        // the baseline always runs, and the fastest usable one is selected
+        VERIFY_IS_TRUE(cpu_impl_usable(&impls[0]));
+        int best = 0;
+        for (int i = 0; i < count; i++) {
+            if (cpu_impl_usable(&impls[i])) {
+                best = i;
+            }
+        }
+        VERIFY_ARE_EQUAL(impls[best].fn, selected_fn(op));
+        VERIFY_IS_ZERO(strcmp(impls[best].name, get_cpu_impl_name(op)));
+    }
+
+    VERIFY_IS_NULL(get_cpu_impls(NR_CPU_OPS, &count));
+    VERIFY_IS_ZERO(count);
+    VERIFY_IS_NULL(get_cpu_op_name(NR_CPU_OPS));
+}
+
+void test_dispatch_impls(void)
+{
+    int count;
+
+    // every implementation this CPU can run must behave the same
+    for (int op = 0; op < NR_CPU_OPS; op++) {
+        const struct cpu_impl *impls = get_cpu_impls(op, &count);
+        for (int i = 0; i < count; i++) {
+            if (cpu_impl_usable(&impls[i])) {
+                check_impl(op, &impls[i]);
+            }
+        }
+    }
+}
+
+static uint32_t bench_impl(enum cpu_op op, const struct cpu_impl *impl)
+{
+    uint32_t va[1] = { (uint32_t) _dst };
+    uint64_t start, end;
+
+    rdtsc(start);
+    for (int i = 0; i < _BENCH_ITER; i++) {
+        __asm__ volatile ("" : : : "memory");
+        switch (op) {
+            case CPU_OP_MEMCPY:
+                ((memcpy_fn) impl->fn)(_dst, _src, PAGE_SIZE);
+                break;
+            case CPU_OP_MEMSET:
+                ((memset_fn) impl->fn)(_dst, i, PAGE_SIZE);
+                break;
+            case CPU_OP_ZERO_PAGE:
+                ((zero_page_fn) impl->fn)(_dst);
+                break;
+            case CPU_OP_FLUSH_PAGES:
+                ((flush_pages_fn) impl->fn)(va, 1);
+                _dst[0]++;  // take the TLB miss
+                break;
+            default:
+                break;
+        }
+    }
+    rdtsc(end);
+
+    return (uint32_t) ((end - start) / _BENCH_ITER);
+}
+
+void bench_cpu_ops(void)
+{
+    struct cpuid cpu;
+    int count;
+
+    if (!get_cpu_info(&cpu) || !cpu.tsc_support) {
+        return;
+    }
+
+    tprint("%-12s %-10s %8s  (cycles per 4K)\n", "op", "impl", "cycles");
+    for (int op = 0; op < NR_CPU_OPS; op++) {
+        const struct cpu_impl *impls = get_cpu_impls(op, &count);
+        for (int i = 0; i < count; i++) {
+            if (!cpu_impl_usable(&impls[i])) {
+                tprint("%-12s %-10s %8s\n", get_cpu_op_name(op), impls[i].name, "n/a");
+                continue;
+            }
+            uint32_t cycles = bench_impl(op, &impls[i]);
+            tprint("%-12s %-10s %8d%s\n", get_cpu_op_name(op), impls[i].name, cycles,
+                (impls[i].fn == selected_fn(op)) ? " *" : "");
+        }
+    }
+}
+
+void test_dispatch(void)
+{
+    DECLARE_TEST("cpu op dispatch");
+
+    test_dispatch_selection();
+    test_dispatch_impls();
+    bench_cpu_ops();
+}
@@ -0,0 +1,130 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: kernel/test/test_kmalloc.c
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * =============================================================================
+ */
+
+#include <string.h>
+#include <test.h>
+#include <kernel/kmalloc.h>
+#include <kernel/mm.h>
+#include <kernel/ohwes.h>
+
+#define _NR_OBJS    300     // enough to spill over a few slabs
+
+static void *objs[_NR_OBJS];
+
+static int class_index(size_t size)
+{
+    struct kmalloc_stats stats;
+    for (int i = 0; get_kmalloc_stats(i, &stats); i++) {
+        if (stats.size == 0 || size <= stats.size) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+void test_kmalloc(void)
+{
+    DECLARE_TEST("kmalloc");
+
+    const size_t sizes[] = {
+        1, 7, 8, 9, 16, 33, 65, 100, 129, 200, 255, 500,
+        KMALLOC_MAX_SIZE, KMALLOC_MAX_SIZE+1, PAGE_SIZE, PAGE_SIZE+1, 3*PAGE_SIZE,
+    };
+    struct kmalloc_stats before, after;
+    int nr_free;
+    char *p;
+
+    // size class pools are set up on first use; do that before the baseline
+    VERIFY_IS_TRUE(get_kmalloc_stats(0, &before));
+    nr_free = verify_free_lists();
+    VERIFY_IS_NULL(kmalloc(0, 0));
+    kfree(NULL);
+
+    // every size lands in a class big enough for it, and frees cleanly
+    for (int i = 0; i < countof(sizes); i++) {
+        int cls = class_index(sizes[i]);
+        get_kmalloc_stats(cls, &before);
+
+        p = kmalloc(sizes[i], 0);
+        VERIFY_IS_NOT_NULL(p);
+        VERIFY_IS_TRUE(aligned(p, KMALLOC_MIN_SIZE));
+        memset(p, 0xA5, sizes[i]);
+
+        get_kmalloc_stats(cls, &after);
+        VERIFY_ARE_EQUAL(before.nr_active + 1, after.nr_active);
+        if (after.size) {
+            VERIFY_IS_TRUE(sizes[i] <= after.size);
+        }
+        else {
+            // page-backed; must not waste pages on a header
+            VERIFY_IS_TRUE(aligned(p, PAGE_SIZE));
+            VERIFY_ARE_EQUAL(before.nr_pages + (1 << get_order(sizes[i])), after.nr_pages);
+        }
+
+        kfree(p);
+        get_kmalloc_stats(cls, &after);
+        VERIFY_ARE_EQUAL(before.nr_active, after.nr_active);
+    }
+
+    // fill several slabs, make sure no two objects overlap
+    int cls = class_index(32);
+    get_kmalloc_stats(cls, &before);
+    for (int i = 0; i < _NR_OBJS; i++) {
+        objs[i] = kmalloc(32, 0);
+        VERIFY_IS_NOT_NULL(objs[i]);
+        memset(objs[i], i & 0xFF, 32);
+    }
+    get_kmalloc_stats(cls, &after);
+    VERIFY_IS_TRUE(after.nr_pages > before.nr_pages + 1);
+    VERIFY_ARE_EQUAL(before.nr_active + _NR_OBJS, after.nr_active);
+    for (int i = 0; i < _NR_OBJS; i++) {
+        p = objs[i];
+        for (int j = 0; j < 32; j++) {
+            VERIFY_ARE_EQUAL(i & 0xFF, p[j] & 0xFF);
+        }
+    }
+
+    // free every other object, then the rest; empty slabs go back to mm
+    for (int i = 0; i < _NR_OBJS; i += 2) {
+        kfree(objs[i]);
+    }
+    for (int i = 1; i < _NR_OBJS; i += 2) {
+        kfree(objs[i]);
+    }
+    get_kmalloc_stats(cls, &after);
+    VERIFY_ARE_EQUAL(before.nr_active, after.nr_active);
+    VERIFY_ARE_EQUAL(before.nr_pages, after.nr_pages);
+
+    // zeroed allocations
+    p = kmalloc(64, 0);
+    memset(p, 0xFF, 64);
+    kfree(p);
+    p = kmalloc(64, ALLOC_ZERO);
+    for (int i = 0; i < 64; i++) {
+        VERIFY_IS_ZERO(p[i]);
+    }
+    kfree(p);
+
+    // everything went back to the page allocator
+    VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
+
+    print_kmalloc_stats();
+}
@@ -0,0 +1,195 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: kernel/test/test_mm.c
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * =============================================================================
+ */
+
+#include <test.h>
+#include <kernel/config.h>
+#include <kernel/kernel.h>
+#include <kernel/mm.h>
+#include <kernel/ohwes.h>
+#include <string.h>
+
+#define _NR_SMALL   16
+#define _NR_HOT     (HOT_CACHE_HIGH * 2)
+
+static void *hot[_NR_HOT];
+
+void test_mm(void)
+{
+    DECLARE_TEST("page allocator");
+
+    void *blocks[MAX_ORDER+1];
+    void *small[_NR_SMALL];
+    int nr_free, used;
+
+    // free lists and bitmap must agree from the get-go
+    nr_free = verify_free_lists();
+    VERIFY_IS_TRUE(nr_free > 0);
+
+    // one block of every order; each must be naturally aligned
+    used = 0;
+    for (int o = 0; o <= MAX_ORDER; o++) {
+        blocks[o] = alloc_pages(0, o);
+        VERIFY_IS_NOT_NULL(blocks[o]);
+        VERIFY_IS_TRUE(aligned(PHYSICAL_ADDR(blocks[o]), get_order_size(o)));
+        used += (1 << o);
+        VERIFY_ARE_EQUAL(nr_free - used, verify_free_lists());
+    }
+
+    // no two blocks may overlap
+    for (int i = 0; i <= MAX_ORDER; i++) {
+        for (int j = i + 1; j <= MAX_ORDER; j++) {
+            uintptr_t a = (uintptr_t) blocks[i];
+            uintptr_t b = (uintptr_t) blocks[j];
+            VERIFY_IS_TRUE(a + get_order_size(i) <= b || b + get_order_size(j) <= a);
+        }
+    }
+
+    // free in a different order than allocated, everything should coalesce
+    for (int o = MAX_ORDER; o >= 0; o -= 2) {
+        free_pages(blocks[o], o);
+        used -= (1 << o);
+        VERIFY_ARE_EQUAL(nr_free - used, verify_free_lists());
+    }
+    for (int o = MAX_ORDER - 1; o >= 0; o -= 2) {
+        free_pages(blocks[o], o);
+        used -= (1 << o);
+        VERIFY_ARE_EQUAL(nr_free - used, verify_free_lists());
+    }
+    VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
+
+    // a double free must not corrupt anything
+    blocks[0] = alloc_pages(0, 0);
+    VERIFY_IS_NOT_NULL(blocks[0]);
+    free_pages(blocks[0], 0);
+    free_pages(blocks[0], 0);
+    VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
+
+    // split a large block into single pages, then merge it back together
+    for (int i = 0; i < _NR_SMALL; i++) {
+        small[i] = alloc_pages(0, 0);
+        VERIFY_IS_NOT_NULL(small[i]);
+    }
+    VERIFY_ARE_EQUAL(nr_free - _NR_SMALL, verify_free_lists());
+    for (int i = _NR_SMALL - 1; i >= 0; i--) {
+        free_pages(small[i], 0);
+    }
+    VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
+
+    // zeroed single pages come out of the reserve while it lasts,
+    // and the reserve fills back up when there's time to zero more
+    struct zero_page_stats before, after;
+    get_zero_page_stats(&before);
+    VERIFY_IS_TRUE(before.nr_reserved > 0);
+    for (int i = 0; i < _NR_SMALL; i++) {
+        small[i] = alloc_pages(ALLOC_ZERO, 0);
+        VERIFY_IS_NOT_NULL(small[i]);
+        uint32_t *p = small[i];
+        for (int k = 0; k < PAGE_SIZE / (int) sizeof(uint32_t); k++) {
+            if (p[k] != 0) {
+                VERIFY_ARE_EQUAL(0, p[k]);
+                break;
+            }
+        }
+        memset(small[i], 0xA5, PAGE_SIZE);
+    }
+    get_zero_page_stats(&after);
+    VERIFY_ARE_EQUAL(_NR_SMALL, (after.nr_hits - before.nr_hits) + (after.nr_misses - before.nr_misses));
+    VERIFY_ARE_EQUAL(min(before.nr_reserved, _NR_SMALL), after.nr_hits - before.nr_hits);
+    VERIFY_ARE_EQUAL(nr_free - _NR_SMALL, verify_free_lists());
+    for (int i = 0; i < _NR_SMALL; i++) {
+        free_pages(small[i], 0);
+    }
+    VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
+    refill_zero_pages(NR_ZERO_PAGES);
+    get_zero_page_stats(&after);
+    VERIFY_ARE_EQUAL(NR_ZERO_PAGES, after.nr_reserved);
+    VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
+
+    // a page in a hot cache must be caught as a double free
+    free_pages(small[0], 0);
+    VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
+
+    // larger zeroed blocks are zeroed on the spot
+    blocks[0] = alloc_pages(ALLOC_ZERO, 2);
+    VERIFY_IS_NOT_NULL(blocks[0]);
+    VERIFY_ARE_EQUAL(0, ((uint32_t *) blocks[0])[get_order_size(2) / sizeof(uint32_t) - 1]);
+    free_pages(blocks[0], 2);
+    VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
+
+    // small blocks come back most-recently-freed first
+    struct hot_cache_stats hot_before, hot_after;
+    for (int o = 0; o < NR_HOT_ORDERS; o++) {
+        blocks[0] = alloc_pages(0, o);
+        VERIFY_IS_NOT_NULL(blocks[0]);
+        free_pages(blocks[0], o);
+        get_hot_cache_stats(&hot_before);
+        blocks[1] = alloc_pages(0, o);
+        get_hot_cache_stats(&hot_after);
+        VERIFY_ARE_EQUAL(blocks[0], blocks[1]);
+        VERIFY_ARE_EQUAL(hot_before.nr_hits + 1, hot_after.nr_hits);
+        free_pages(blocks[1], o);
+        VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
+    }
+
+    // freeing more than the cache holds gives the excess back in batches
+    get_hot_cache_stats(&hot_before);
+    for (int i = 0; i < _NR_HOT; i++) {
+        hot[i] = alloc_pages(0, 0);
+        VERIFY_IS_NOT_NULL(hot[i]);
+    }
+    VERIFY_ARE_EQUAL(nr_free - _NR_HOT, verify_free_lists());
+    for (int i = 0; i < _NR_HOT; i++) {
+        free_pages(hot[i], 0);
+    }
+    get_hot_cache_stats(&hot_after);
+    VERIFY_IS_TRUE(hot_after.nr_refills > hot_before.nr_refills);
+    VERIFY_IS_TRUE(hot_after.nr_drains > hot_before.nr_drains);
+    VERIFY_IS_TRUE(hot_after.nr_cached[0] <= HOT_CACHE_HIGH);
+    VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
+
+    // once the free lists run dry, blocks scattered across the caches are
+    // merged back together before an allocation gives up; use up everything
+    // but a spare block, chaining the blocks through their first two words
+    void *spare, *chain, *p;
+    spare = alloc_pages(0, 2);
+    VERIFY_IS_NOT_NULL(spare);
+    chain = NULL;
+    for (int o = MAX_ORDER; o >= 0; o--) {
+        while ((p = alloc_pages(0, o)) != NULL) {
+            ((void **) p)[0] = chain;
+            ((int *) p)[1] = o;
+            chain = p;
+        }
+    }
+    free_pages(spare, 2);
+    blocks[0] = alloc_pages(0, 0);      // splits the spare into the order 0 cache
+    VERIFY_IS_NOT_NULL(blocks[0]);
+    free_pages(blocks[0], 0);
+    blocks[1] = alloc_pages(0, 1);
+    VERIFY_IS_NOT_NULL(blocks[1]);
+    free_pages(blocks[1], 1);
+    while (chain != NULL) {
+        p = chain;
+        chain = ((void **) p)[0];
+        free_pages(p, ((int *) p)[1]);
+    }
+    VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
+}
@@ -0,0 +1,126 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: kernel/test/test_pgtbl.c
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * =============================================================================
+ */
+
+#include <test.h>
+#include <i386/cpu.h>
+#include <i386/paging.h>
+#include <i386/x86.h>
+#include <kernel/kernel.h>
+#include <kernel/mm.h>
+#include <kernel/ohwes.h>
+
+#define _SCRATCH_VA     0xFF000000  // nothing lives up here
+#define _NR_ITER        1000
+#define _WSET_ORDER     4           // working set touched between remaps
+
+static volatile uint32_t *_wset;
+
+// touch one word on every page of the working set, so a full TLB flush
+// costs us a refill on the next pass
+static void touch_wset(void)
+{
+    for (int i = 0; i < (1 << _WSET_ORDER); i++) {
+        (void) _wset[i << (PAGE_SHIFT - 2)];
+    }
+}
+
+static uint32_t bench_remap(uint32_t pa0, uint32_t pa1, bool flush_all)
+{
+    struct map_batch batch;
+    uint64_t start, end;
+
+    rdtsc(start);
+    for (int i = 0; i < _NR_ITER; i++) {
+        map_batch_init(&batch);
+        map_batch_add(&batch, _SCRATCH_VA, (i & 1) ? pa1 : pa0, _PAGE_RW);
+        batch.flush_all = flush_all;
+        map_batch_commit(&batch);
+        (void) *((volatile uint32_t *) _SCRATCH_VA);
+        touch_wset();
+    }
+    rdtsc(end);
+
+    return (uint32_t) ((end - start) / _NR_ITER);
+}
+
+void test_pgtbl(void)
+{
+    DECLARE_TEST("page table updates");
+
+    struct map_batch batch;
+    struct cpuid cpu;
+    uint32_t *page0, *page1;
+    uint32_t pa0, pa1;
+    pte_t *pte;
+
+    page0 = alloc_pages(0, 0);
+    page1 = alloc_pages(0, 0);
+    _wset = alloc_pages(0, _WSET_ORDER);
+    VERIFY_IS_NOT_NULL(page0);
+    VERIFY_IS_NOT_NULL(page1);
+    VERIFY_IS_NOT_NULL(_wset);
+    page0[0] = 0xAAAAAAAA;
+    page1[0] = 0x55555555;
+    pa0 = PHYSICAL_ADDR(page0);
+    pa1 = PHYSICAL_ADDR(page1);
+
+    // fresh mapping; a new page table is allocated on demand
+    VERIFY_IS_FALSE(virt_addr_valid((void *) _SCRATCH_VA));
+    map_batch_init(&batch);
+    map_batch_add(&batch, _SCRATCH_VA, pa0, _PAGE_RW);
+    VERIFY_ARE_EQUAL(0, batch.count);   // was not present, nothing to invalidate
+    map_batch_commit(&batch);
+    VERIFY_IS_TRUE(walk_page_table(_SCRATCH_VA, &pte));
+    VERIFY_ARE_EQUAL(pa0, *pte & PAGE_MASK);
+    VERIFY_ARE_EQUAL(0xAAAAAAAA, *((volatile uint32_t *) _SCRATCH_VA));
+
+    // remap; invlpg must drop the stale translation we just used
+    map_batch_add(&batch, _SCRATCH_VA, pa1, _PAGE_RW);
+    VERIFY_ARE_EQUAL(1, batch.count);
+    VERIFY_IS_FALSE(batch.flush_all);
+    map_batch_commit(&batch);
+    VERIFY_ARE_EQUAL(0x55555555, *((volatile uint32_t *) _SCRATCH_VA));
+
+    // a big batch falls back to a full flush
+    for (int i = 0; i <= MAP_BATCH_SIZE; i++) {
+        map_batch_add(&batch, _SCRATCH_VA, (i & 1) ? pa1 : pa0, _PAGE_RW);
+    }
+    VERIFY_IS_TRUE(batch.flush_all);
+    map_batch_commit(&batch);
+    VERIFY_ARE_EQUAL(0xAAAAAAAA, *((volatile uint32_t *) _SCRATCH_VA));
+
+    // cycle cost of a remap plus touching the working set afterwards
+    if (get_cpu_info(&cpu) && cpu.tsc_support) {
+        uint32_t full = bench_remap(pa0, pa1, true);
+        uint32_t single = bench_remap(pa0, pa1, false);
+        tprint("remap+touch %d pages: flush_tlb %d cycles, invlpg %d cycles\n",
+            (1 << _WSET_ORDER) + 1, full, single);
+    }
+
+    // unmap
+    map_batch_add(&batch, _SCRATCH_VA, 0, 0);
+    map_batch_commit(&batch);
+    VERIFY_IS_FALSE(virt_addr_valid((void *) _SCRATCH_VA));
+
+    free_pages((void *) _wset, _WSET_ORDER);
+    free_pages(page1, 0);
+    free_pages(page0, 0);
+}
@@ -24,6 +24,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <test.h>
+#include <kernel/mm.h>
 #include <kernel/pool.h>
 
 struct thing {
@@ -31,89 +32,158 @@ struct thing {
     char name[8];
 };
 
-#define _MAX_SLOTS 4
-static struct thing _pool0[_MAX_SLOTS];
-static struct thing _pool1[_MAX_SLOTS];
+#define _MAX_THINGS 1024    // enough to need a bunch of slabs
+
+static struct thing *things[_MAX_THINGS];
 
 void test_pool(void)
 {
     DECLARE_TEST("object pool");
 
-    pool_t p0, p1;
+    pool_t *p0, *p1;
     struct thing *thing0, *thing1;
-    struct thing *things[_MAX_SLOTS*2];
     char zeros[sizeof(struct thing)];
+    char *page;
+    int nr_free, n, half;
     memset(zeros, 0, sizeof(zeros));
 
-    // create/destroy single pool
-    p0 = pool_create(_pool0, "p0", sizeof(struct thing), _MAX_SLOTS);
-    VERIFY_IS_NOT_ZERO(p0);
+    // bad args
+    VERIFY_IS_NULL(pool_create(NULL, sizeof(struct thing), 0));
+    VERIFY_IS_NULL(pool_create("p0", 0, 0));
+    VERIFY_IS_NULL(pool_create("bad name", sizeof(struct thing), 0));
+    VERIFY_IS_NULL(pool_create("p0", MAX_ORDER_SIZE, 0));
+
+    // create/destroy single pool; no memory used until first alloc
+    p0 = pool_create("p0", sizeof(struct thing), 0);
+    VERIFY_IS_NOT_NULL(p0);
+    nr_free = verify_free_lists();
+    VERIFY_IS_NULL(pool_create("p0", sizeof(struct thing), 0));
+    VERIFY_ARE_EQUAL(0, p0->nr_slabs);
+    VERIFY_ARE_EQUAL(0, p0->capacity);
+    VERIFY_IS_TRUE(p0->per_slab > 1);
+    VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
     pool_destroy(p0);
 
-    // fill pool
-    p0 = pool_create(_pool0, "p0", sizeof(struct thing), _MAX_SLOTS);
-    VERIFY_IS_NOT_ZERO(p0);
-    for (int i = 0; i < _MAX_SLOTS; i++) {
-        things[i] = pool_alloc(p0);
+    // fill one slab, then keep going; the pool must grow instead of failing
+    p0 = pool_create("p0", sizeof(struct thing), 0);
+    VERIFY_IS_NOT_NULL(p0);
+    n = p0->per_slab * 2 + 1;
+    VERIFY_IS_TRUE(n <= _MAX_THINGS);
+    for (int i = 0; i < n; i++) {
+        things[i] = pool_alloc(p0, 0);
         VERIFY_IS_NOT_NULL(things[i]);
+        VERIFY_ARE_EQUAL(p0, pool_of(things[i]));
         things[i]->id = i;
-        snprintf(things[i]->name, 8, "thing%d", i);
+        snprintf(things[i]->name, 8, "t%d", i);
     }
+    VERIFY_ARE_EQUAL(3, p0->nr_slabs);
+    VERIFY_ARE_EQUAL(n, p0->count);
+    VERIFY_ARE_EQUAL(3 * p0->per_slab, p0->capacity);
+    VERIFY_ARE_EQUAL(nr_free - 3 * (1 << p0->order), verify_free_lists());
+
     // ensure nothing got overwritten
-    for (int i = 0; i < _MAX_SLOTS; i++) {
+    for (int i = 0; i < n; i++) {
         char buf[8];
-        snprintf(buf, sizeof(buf), "thing%d", i);
+        snprintf(buf, sizeof(buf), "t%d", i);
         VERIFY_ARE_EQUAL(i, things[i]->id);
-        VERIFY_IS_ZERO(strcmp(buf, things[i]->name));
+        VERIFY_IS_ZERO(strncmp(buf, things[i]->name, 8));
     }
-    // ensure we can't overflow
-    thing0 = pool_alloc(p0);
-    VERIFY_IS_NULL(thing0);
 
-    // now, free one item and attempt to alloc
-    pool_free(p0, things[0]);
-    thing0 = pool_alloc(p0);
-    VERIFY_IS_NOT_NULL(thing0);
+    // now, free one item and attempt to alloc; the slot should be reused
+    thing0 = things[0];
+    pool_free(p0, thing0);
+    VERIFY_ARE_EQUAL(n - 1, p0->count);
+    things[0] = pool_alloc(p0, ALLOC_ZERO);
+    VERIFY_ARE_EQUAL(thing0, things[0]);
+    VERIFY_ARE_EQUAL(3, p0->nr_slabs);
+
+    // was the new allocation zeroed?
+    VERIFY_IS_ZERO(memcmp(zeros, things[0], sizeof(struct thing)));
 
-    // bonus! was the new allocation zeroed?
-    VERIFY_IS_ZERO(memcmp(zeros, thing0, sizeof(struct thing)));
+    // bogus frees are ignored
+    pool_free(p0, (char *) things[1] + 1);
+    VERIFY_ARE_EQUAL(n, p0->count);
+    page = alloc_pages(ALLOC_ZERO, 0);
+    VERIFY_ARE_EQUAL(INVALID_POOL, pool_of(page + sizeof(struct thing)));
+    free_pages(page, 0);
+
+    // free the last slab's lone item; its slab goes back to mm
+    pool_free(p0, things[n-1]);
+    VERIFY_ARE_EQUAL(2, p0->nr_slabs);
+    VERIFY_ARE_EQUAL(nr_free - 2 * (1 << p0->order), verify_free_lists());
+
+    // free every other item; slabs stay put while partially used
+    half = 0;
+    for (int i = 0; i < n - 1; i += 2, half++) {
+        pool_free(p0, things[i]);
+        things[i] = NULL;
+    }
+    VERIFY_ARE_EQUAL(n - 1 - half, p0->count);
+    VERIFY_ARE_EQUAL(2, p0->nr_slabs);
+
+    // freed slots are handed out again before growing
+    for (int i = 0; i < n - 1; i += 2) {
+        things[i] = pool_alloc(p0, 0);
+        VERIFY_IS_NOT_NULL(things[i]);
+    }
+    VERIFY_ARE_EQUAL(2, p0->nr_slabs);
+
+    // free everything; all slabs are given back
+    for (int i = 0; i < n - 1; i++) {
+        pool_free(p0, things[i]);
+    }
+    VERIFY_ARE_EQUAL(0, p0->count);
+    VERIFY_ARE_EQUAL(0, p0->nr_slabs);
+    VERIFY_ARE_EQUAL(0, p0->capacity);
+    VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
 
     // destroy pool
     pool_destroy(p0);
 
     // create multiple concurrent pools, ensure there is no crosstalk
-    p0 = pool_create(_pool0, "p0", sizeof(struct thing), _MAX_SLOTS);
-    p1 = pool_create(_pool1, "p1", sizeof(struct thing), _MAX_SLOTS);
-    VERIFY_IS_NOT_ZERO(p0);
-    VERIFY_IS_NOT_ZERO(p1);
+    p0 = pool_create("p0", sizeof(struct thing), 0);
+    p1 = pool_create("p1", sizeof(struct thing), 0);
+    VERIFY_IS_NOT_NULL(p0);
+    VERIFY_IS_NOT_NULL(p1);
     VERIFY_ARE_NOT_EQUAL(p1, p0);
 
-    // fill both pools
-    for (int i = 0; i < _MAX_SLOTS; i++) {
-        thing0 = pool_alloc(p0);
-        thing1 = pool_alloc(p1);
-        snprintf(thing0->name, 8, "thingA%d", i);
-        snprintf(thing1->name, 8, "thingB%d", i);
+    // fill both pools, interleaved
+    half = _MAX_THINGS / 2;
+    for (int i = 0; i < half; i++) {
+        thing0 = pool_alloc(p0, 0);
+        thing1 = pool_alloc(p1, 0);
+        VERIFY_IS_NOT_NULL(thing0);
+        VERIFY_IS_NOT_NULL(thing1);
+        snprintf(thing0->name, 8, "A%d", i);
+        snprintf(thing1->name, 8, "B%d", i);
         thing0->id = i;
-        thing1->id = i+_MAX_SLOTS;
+        thing1->id = i+half;
         things[i] = thing0;
-        things[i+_MAX_SLOTS] = thing1;
+        things[i+half] = thing1;
     }
     // verify no corruption
-    for (int i = 0; i < _MAX_SLOTS; i++) {
+    for (int i = 0; i < half; i++) {
         char buf0[8], buf1[8];
-        snprintf(buf0, sizeof(buf0), "thingA%d", i);
-        snprintf(buf1, sizeof(buf1), "thingB%d", i);
+        snprintf(buf0, sizeof(buf0), "A%d", i);
+        snprintf(buf1, sizeof(buf1), "B%d", i);
         thing0 = things[i];
-        thing1 = things[i+_MAX_SLOTS];
+        thing1 = things[i+half];
         VERIFY_ARE_NOT_EQUAL(thing0, thing1);
+        VERIFY_ARE_EQUAL(p0, pool_of(thing0));
+        VERIFY_ARE_EQUAL(p1, pool_of(thing1));
         VERIFY_ARE_EQUAL(i, thing0->id);
-        VERIFY_ARE_EQUAL(i+_MAX_SLOTS, thing1->id);
+        VERIFY_ARE_EQUAL(i+half, thing1->id);
         VERIFY_IS_ZERO(strncmp(buf0, thing0->name, 8));
         VERIFY_IS_ZERO(strncmp(buf1, thing1->name, 8));
     }
 
-    // destroy pools
+    // an item from one pool can't be freed into another
+    pool_free(p1, things[0]);
+    VERIFY_ARE_EQUAL(half, p0->count);
+    VERIFY_ARE_EQUAL(half, p1->count);
+
+    // destroying a pool with live items still returns all of its slabs
     pool_destroy(p1);
     pool_destroy(p0);
+    VERIFY_ARE_EQUAL(nr_free, verify_free_lists());
 }
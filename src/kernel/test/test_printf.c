@@ -1,5 +1,6 @@
 #include <errno.h>
 #include <inttypes.h>
+#include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
@@ -7,8 +8,11 @@
 #include "test.h"
 
 #if __KERNEL__
+#include <i386/cpu.h>
+#include <i386/x86.h>
 #include <kernel/kernel.h>
-#define _console_write      _kprint
+#include <kernel/ohwes.h>
+#define _console_write(s)   kprint("%s", s)
 #else
 #define _console_write      _wr
 void _wr(const char *msg)
@@ -58,6 +62,135 @@ void printf_reference()
                                      UINT32_MAX,     UINT32_MAX );
 }
 
+//
+// vcbprintf sink that appends to a buffer and counts calls
+//
+
+struct sink_buf {
+    char buf[64];
+    size_t len;
+    int calls;
+    int fail_after;     // return an error on this call, if nonzero
+};
+
+static int test_sink(void *arg, const char *buf, size_t count)
+{
+    struct sink_buf *sb = (struct sink_buf *) arg;
+
+    if (++sb->calls == sb->fail_after) {
+        return -EIO;
+    }
+    memcpy(&sb->buf[sb->len], buf, count);
+    sb->len += count;
+    sb->buf[sb->len] = '\0';
+    return count;
+}
+
+static int cbprintf(struct sink_buf *sb, const char *format, ...)
+{
+    va_list args;
+    int count;
+
+    va_start(args, format);
+    count = vcbprintf(test_sink, sb, format, args);
+    va_end(args);
+
+    return count;
+}
+
+void test_vcbprintf(void)
+{
+    struct sink_buf sb = { };
+
+    // literal runs come through in one piece
+    VERIFY_ARE_EQUAL(14, cbprintf(&sb, "Hello, world!\n"));
+    VERIFY_ARE_EQUAL(1, sb.calls);
+    VERIFY_IS_ZERO(strcmp(sb.buf, "Hello, world!\n"));
+
+    // one span per piece of a conversion, and no NUL
+    sb = (struct sink_buf) { };
+    VERIFY_ARE_EQUAL(12, cbprintf(&sb, "a=%-4db=%X", 42, 0xBEEF));
+    VERIFY_IS_ZERO(strcmp(sb.buf, "a=42  b=BEEF"));
+    VERIFY_ARE_EQUAL(5, sb.calls);
+
+    // sink errors stop formatting
+    sb = (struct sink_buf) { .fail_after = 2 };
+    VERIFY_ARE_EQUAL(-EIO, cbprintf(&sb, "a%db", 1));
+    VERIFY_IS_ZERO(strcmp(sb.buf, "a"));
+    VERIFY_ARE_EQUAL(2, sb.calls);
+
+    VERIFY_ARE_EQUAL(-EINVAL, vcbprintf(NULL, NULL, "", NULL));
+}
+
+//
+// throughput of typical kernel log lines, in formatted chars per million TSC
+// cycles
+//
+
+#define _BENCH_ITER     64
+
+static char _bench_buf[256];
+
+enum bench_fmt {
+    _LITERAL, _LOGLINE, _DECIMAL, _DECIMAL64, _HEX, _PADDED,
+    _NR_BENCH_FMTS
+};
+
+static int bench_fmt(enum bench_fmt fmt, int i)
+{
+    char *buf = _bench_buf;
+    size_t n = sizeof(_bench_buf);
+
+    switch (fmt) {
+        case _LITERAL:
+            return snprintf(buf, n, "tty: line discipline ready, echo on, canonical mode on\n");
+        case _LOGLINE:
+            return snprintf(buf, n, "mem: %s: alloc %08X-%08X order %d; %d pages left\n",
+                "normal", 0xC0400000 + i, 0xC0400FFF + i, i & 7, 30000 - i);
+        case _DECIMAL:
+            return snprintf(buf, n, "%d %d %d %d %u %u\n",
+                i, -12345 * i, 1000000 + i, 42, 4000000000U - i, 7);
+        case _DECIMAL64:
+            return snprintf(buf, n, "%llu %lld\n",
+                18000000000000000000ULL - i, -9000000000000LL * i);
+        case _HEX:
+            return snprintf(buf, n, "%x %X %#x %08X %llX\n",
+                i, 0xDEADBEEF, 0x1000 + i, 0xABC, 0x123456789ABCDEFULL);
+        case _PADDED:
+            return snprintf(buf, n, "[%-24s][%24s][%032d]\n", "left", "right", i);
+        default:
+            return 0;
+    }
+}
+
+void bench_printf(void)
+{
+    static const char *names[] = {
+        "literal", "logline", "decimal", "dec64", "hex", "padded"
+    };
+    struct cpuid cpu;
+    uint64_t start, end;
+
+    if (!get_cpu_info(&cpu) || !cpu.tsc_support) {
+        return;
+    }
+
+    tprint("%-8s %6s %8s %10s\n", "format", "chars", "cyc/char", "chars/Mcyc");
+    for (int fmt = 0; fmt < _NR_BENCH_FMTS; fmt++) {
+        uint32_t chars = 0;
+
+        rdtsc(start);
+        for (int i = 0; i < _BENCH_ITER; i++) {
+            chars += bench_fmt(fmt, i);
+        }
+        rdtsc(end);
+
+        uint32_t cycles = (uint32_t) (end - start);
+        tprint("%-8s %6d %8d %10d\n", names[fmt], chars, cycles / chars,
+            (uint32_t) (((uint64_t) chars * 1000000) / cycles));
+    }
+}
+
 void test_printf(void)
 {
     DECLARE_TEST("sprintf");
@@ -124,10 +257,20 @@ void test_printf(void)
     // snprintf return value is num chars that would've been printed had limit
     //   not been reached
     TEST_SNPRINTF(0, "", 0, NULL);  // NULL ok if n==0
-    TEST_SNPRINTF(3, "a", 1, "abc");
-    TEST_SNPRINTF(3, "abc", 3, "abc");
+    TEST_SNPRINTF(3, "", 1, "abc"); // room for the NUL only
+    TEST_SNPRINTF(3, "ab", 3, "abc");
+    TEST_SNPRINTF(3, "abc", 4, "abc");
     TEST_SNPRINTF(3, "", 0, "abc");
-    TEST_SNPRINTF(3, "a", 1, "abc");
+    TEST_SNPRINTF(5, "1", 2, "%d", 12345);
+
+    // snprintf never writes past bufsz, NUL included
+    memset(buf, 'Z', sizeof(buf));
+    VERIFY_ARE_EQUAL(6, snprintf(buf, 4, "abcdef"));
+    VERIFY_IS_ZERO(strcmp(buf, "abc"));
+    VERIFY_ARE_EQUAL('Z', buf[4]);
+    memset(buf, 'Z', sizeof(buf));
+    VERIFY_ARE_EQUAL(3, snprintf(buf, 0, "abc"));
+    VERIFY_ARE_EQUAL('Z', buf[0]);
 
     #undef TEST_SPRINTF
     #undef TEST_SNPRINTF
@@ -176,6 +319,9 @@ void test_printf(void)
         TEST("%.-8d", "%%.-8d");                // oops! you typed a double percent
         TEST("A %#045.123q B", "A %#045.123q B");// unknown format char, complicated
         TEST("dfs%qwerty%,l;'p", "dfs%qwerty%,l;'p");   // straight gibberish
+        TEST("abc%", "abc%");                   // lone percent at end
+        TEST("abc%l", "abc%l");                 // format ends mid-spec
+        TEST("abc%08", "abc%08");               // format ends mid-spec
     }
 
     //
@@ -212,6 +358,9 @@ void test_printf(void)
         TEST("   ABCDEFG",  "%10.*s", -3, "ABCDEFG");// negative precision (ignored)
         TEST("   ABC",      "%*.*s", 6, 3, "ABCDEFG");  // precision & width w/ args
         TEST("ABCDEFGHIJKLMN","%-13.14s", "ABCDEFGHIJKLMNOP");  // complicated format
+        TEST("       ABC",  "%10.20s", "ABC");  // precision exceeds length w/ width
+        TEST("ABC                                ", "%-35s", "ABC");    // long padding
+        TEST("a1b22c333d",  "a%db%dc%dd", 1, 22, 333);  // literals between conversions
     }
 
     //
@@ -412,6 +561,9 @@ void test_printf(void)
         TEST("  00000123",  "%*.*d",10,8,123);  // width & precision w/ arg
         TEST("123",         "%#d", 123);        // alternative representation (ignored on decimal integers)
         TEST("       +000009223372036854775807", "%+# 032.24lld", 0x7FFFFFFFFFFFFFFFLL); // big complicated format
+        TEST("000000000000000000000000000000000000000042", "%042d", 42);    // long zero padding
+        TEST("9 10 99 100 999 1000 4294967296 10000000000", "%d %d %d %d %d %d %llu %llu",
+            9, 10, 99, 100, 999, 1000, 4294967296ULL, 10000000000ULL);     // digit pair boundaries
     }
     {
         //
@@ -461,9 +613,14 @@ void test_printf(void)
         TEST("00000000",    "%#08x", 0);        // alternative representation w/ width, zero-pad
         TEST("A55",         "%X", 0xa55);       // uppercase
         TEST("0XA55",       "%#X", 0xa55);      // uppercase, alternative representation
+        TEST("123456789abcdef0", "%llx", 0x123456789abcdef0ULL);   // 64-bit, both halves
+        TEST("1234567012345670", "%llo", 01234567012345670ULL);    // 64-bit octal
     }
 
     #undef TEST
     #undef _TEST_CHECK
     #undef _TEST_FN
+
+    test_vcbprintf();
+    bench_printf();
 }
@@ -19,9 +19,210 @@
  * =============================================================================
  */
 
+#include <string.h>
 #include <test.h>
+#include <kernel/ohwes.h>
 #include <kernel/queue.h>
 
+struct test_rec {
+    uint32_t seq;
+    uint16_t code;
+    bool flag;
+};
+
+DECLARE_RING(test_recq, struct test_rec, 4);
+DECLARE_RING(test_charq, char, 8);
+
+// bulk operations on a ring of the given length; run for both masked
+// (power-of-2) and compare-wrapped lengths
+static void test_ring_bulk(size_t length)
+{
+    char buf[8];
+    char out[16];
+    struct ring _queue;
+    struct ring *queue = &_queue;
+    const char *rptr;
+    char *wptr;
+
+    ring_init(queue, buf, length);
+    VERIFY_ARE_EQUAL(length, ring_space(queue));
+
+    // partial write when there isn't enough room
+    VERIFY_ARE_EQUAL(length, ring_write(queue, "0123456789", 10));
+    VERIFY_IS_TRUE(ring_full(queue));
+    VERIFY_ARE_EQUAL(0, ring_space(queue));
+    VERIFY_ARE_EQUAL(0, ring_write(queue, "X", 1));
+
+    // peek leaves the contents alone
+    memset(out, 0, sizeof(out));
+    VERIFY_ARE_EQUAL(3, ring_peek(queue, out, 3));
+    VERIFY_IS_ZERO(strcmp(out, "012"));
+    VERIFY_ARE_EQUAL(length, ring_count(queue));
+
+    // read part, then write across the end of the buffer
+    memset(out, 0, sizeof(out));
+    VERIFY_ARE_EQUAL(3, ring_read(queue, out, 3));
+    VERIFY_IS_ZERO(strcmp(out, "012"));
+    VERIFY_ARE_EQUAL(3, ring_write(queue, "abc", 3));
+    VERIFY_IS_TRUE(ring_full(queue));
+
+    // peek and read across the end of the buffer
+    memset(out, 0, sizeof(out));
+    VERIFY_ARE_EQUAL(length, ring_peek(queue, out, sizeof(out)));
+    VERIFY_IS_ZERO(memcmp(out + length - 3, "abc", 3));
+    VERIFY_IS_ZERO(memcmp(out, "3456789" , length - 3));
+    memset(out, 0, sizeof(out));
+    VERIFY_ARE_EQUAL(length, ring_read(queue, out, sizeof(out)));
+    VERIFY_IS_ZERO(memcmp(out + length - 3, "abc", 3));
+    VERIFY_IS_TRUE(ring_empty(queue));
+    VERIFY_ARE_EQUAL(0, ring_read(queue, out, sizeof(out)));
+
+    // single-char ops agree with the bulk ones around the wrap
+    VERIFY_IS_TRUE(ring_put(queue, 'p'));
+    VERIFY_ARE_EQUAL(2, ring_write(queue, "qr", 2));
+    VERIFY_IS_TRUE(ring_get(queue) == 'p');
+    VERIFY_IS_TRUE(ring_get(queue) == 'q');
+    VERIFY_ARE_EQUAL(1, ring_read(queue, out, 4));
+    VERIFY_IS_TRUE(out[0] == 'r');
+    VERIFY_IS_TRUE(ring_empty(queue));
+
+    // regions stop at the end of the buffer
+    ring_clear(queue);
+    VERIFY_ARE_EQUAL(length - 2, ring_write(queue, "ABCDEFGH", length - 2));
+    ring_skip(queue, length - 3);
+    VERIFY_ARE_EQUAL(2, ring_write_region(queue, &wptr));
+    VERIFY_IS_TRUE(wptr == &buf[length - 2]);
+    wptr[0] = 'y'; wptr[1] = 'z';
+    ring_commit(queue, 2);
+    VERIFY_ARE_EQUAL(length - 3, ring_write_region(queue, &wptr));
+    VERIFY_IS_TRUE(wptr == &buf[0]);
+    wptr[0] = '!';
+    ring_commit(queue, 1);
+    VERIFY_ARE_EQUAL(4, ring_count(queue));
+
+    VERIFY_ARE_EQUAL(3, ring_read_region(queue, &rptr));
+    VERIFY_IS_TRUE(rptr[1] == 'y' && rptr[2] == 'z');
+    ring_skip(queue, 3);
+    VERIFY_ARE_EQUAL(1, ring_read_region(queue, &rptr));
+    VERIFY_IS_TRUE(rptr[0] == '!');
+    ring_skip(queue, 10);   // clamped
+    VERIFY_IS_TRUE(ring_empty(queue));
+    VERIFY_ARE_EQUAL(0, ring_read_region(queue, &rptr));
+
+    // a full ring has no write region
+    ring_write(queue, "ABCDEFGH", length);
+    VERIFY_ARE_EQUAL(0, ring_write_region(queue, &wptr));
+    ring_commit(queue, 1);  // clamped
+    VERIFY_ARE_EQUAL(length, ring_count(queue));
+}
+
+static void test_spsc_ring(void)
+{
+    char buf[8];
+    char out[16];
+    char c;
+    struct spsc_ring _queue;
+    struct spsc_ring *queue = &_queue;
+
+    spsc_init(queue, buf, sizeof(buf));
+    VERIFY_ARE_EQUAL(0, spsc_count(queue));
+    VERIFY_ARE_EQUAL(8, spsc_space(queue));
+    VERIFY_IS_FALSE(spsc_get(queue, &c));
+
+    // single chars, then fill
+    VERIFY_IS_TRUE(spsc_put(queue, 'A'));
+    VERIFY_IS_TRUE(spsc_get(queue, &c));
+    VERIFY_IS_TRUE(c == 'A');
+    VERIFY_ARE_EQUAL(8, spsc_write(queue, "0123456789", 10));
+    VERIFY_ARE_EQUAL(0, spsc_space(queue));
+    VERIFY_IS_FALSE(spsc_put(queue, 'X'));
+
+    // read across the end of the buffer
+    memset(out, 0, sizeof(out));
+    VERIFY_ARE_EQUAL(8, spsc_read(queue, out, sizeof(out)));
+    VERIFY_IS_ZERO(strcmp(out, "01234567"));
+    VERIFY_ARE_EQUAL(0, spsc_count(queue));
+
+    // indices run freely and keep working when they overflow
+    queue->head = queue->tail = 0xFFFFFFFC;
+    VERIFY_ARE_EQUAL(6, spsc_write(queue, "abcdef", 6));
+    VERIFY_ARE_EQUAL(6, spsc_count(queue));
+    VERIFY_ARE_EQUAL(2, spsc_space(queue));
+    VERIFY_IS_TRUE(spsc_get(queue, &c));
+    VERIFY_IS_TRUE(c == 'a');
+    memset(out, 0, sizeof(out));
+    VERIFY_ARE_EQUAL(5, spsc_read(queue, out, sizeof(out)));
+    VERIFY_IS_ZERO(strcmp(out, "bcdef"));
+    VERIFY_ARE_EQUAL(2, queue->tail);
+
+    // clear drops everything
+    VERIFY_ARE_EQUAL(3, spsc_write(queue, "xyz", 3));
+    spsc_clear(queue);
+    VERIFY_ARE_EQUAL(0, spsc_count(queue));
+    VERIFY_IS_FALSE(spsc_get(queue, &c));
+}
+
+static void test_typed_ring(void)
+{
+    struct test_recq _recq;
+    struct test_recq *recq = &_recq;
+    struct test_charq _charq;
+    struct test_charq *charq = &_charq;
+    struct test_rec rec;
+    struct test_rec recs[8];
+    char out[16];
+
+    // single elements of a struct type
+    test_recq_init(recq);
+    VERIFY_IS_TRUE(test_recq_empty(recq));
+    VERIFY_ARE_EQUAL(4, test_recq_space(recq));
+    VERIFY_IS_FALSE(test_recq_get(recq, &rec));
+    VERIFY_IS_NULL(test_recq_peek(recq));
+    for (int i = 0; i < 4; i++) {
+        rec = (struct test_rec) { .seq = 100 + i, .code = i, .flag = (i & 1) };
+        VERIFY_IS_TRUE(test_recq_put(recq, rec));
+    }
+    VERIFY_IS_TRUE(test_recq_full(recq));
+    VERIFY_IS_FALSE(test_recq_put(recq, rec));
+    VERIFY_ARE_EQUAL(100, test_recq_peek(recq)->seq);
+    VERIFY_IS_TRUE(test_recq_get(recq, &rec));
+    VERIFY_ARE_EQUAL(100, rec.seq);
+    VERIFY_ARE_EQUAL(0, rec.code);
+    VERIFY_IS_FALSE(rec.flag);
+    VERIFY_ARE_EQUAL(3, test_recq_count(recq));
+
+    // bulk write and read across the end of the buffer
+    for (int i = 0; i < countof(recs); i++) {
+        recs[i] = (struct test_rec) { .seq = 200 + i, .code = i, .flag = true };
+    }
+    VERIFY_ARE_EQUAL(1, test_recq_write(recq, recs, countof(recs)));
+    memset(recs, 0, sizeof(recs));
+    VERIFY_ARE_EQUAL(4, test_recq_read(recq, recs, countof(recs)));
+    VERIFY_ARE_EQUAL(101, recs[0].seq);
+    VERIFY_ARE_EQUAL(102, recs[1].seq);
+    VERIFY_ARE_EQUAL(103, recs[2].seq);
+    VERIFY_ARE_EQUAL(200, recs[3].seq);
+    VERIFY_IS_TRUE(recs[3].flag);
+    VERIFY_IS_TRUE(test_recq_empty(recq));
+
+    // indices run freely and keep working when they overflow
+    test_charq_init(charq);
+    charq->head = charq->tail = 0xFFFFFFFE;
+    VERIFY_ARE_EQUAL(8, test_charq_write(charq, "0123456789", 10));
+    VERIFY_IS_TRUE(test_charq_full(charq));
+    VERIFY_ARE_EQUAL(0, test_charq_space(charq));
+    VERIFY_ARE_EQUAL('0', *test_charq_peek(charq));
+    memset(out, 0, sizeof(out));
+    VERIFY_ARE_EQUAL(3, test_charq_read(charq, out, 3));
+    VERIFY_IS_ZERO(strcmp(out, "012"));
+    VERIFY_IS_TRUE(test_charq_put(charq, 'x'));
+    memset(out, 0, sizeof(out));
+    VERIFY_ARE_EQUAL(6, test_charq_read(charq, out, sizeof(out)));
+    VERIFY_IS_ZERO(strcmp(out, "34567x"));
+    VERIFY_ARE_EQUAL(0, test_charq_count(charq));
+    VERIFY_ARE_EQUAL(7, charq->tail);
+}
+
 void test_ring(void)
 {
     DECLARE_TEST("ring buffer");
@@ -109,4 +310,14 @@ void test_ring(void)
     VERIFY_IS_TRUE(ring_get(queue) == '1');
     VERIFY_IS_TRUE(ring_get(queue) == '2');
     VERIFY_IS_TRUE(ring_empty(queue));
+
+    // bulk operations
+    test_ring_bulk(8);
+    test_ring_bulk(5);
+
+    // lock-free single-producer, single-consumer
+    test_spsc_ring();
+
+    // typed rings
+    test_typed_ring();
 }
@@ -1,6 +1,9 @@
 #include <stdio.h>
 #include <string.h>
 #include <test.h>
+#include <i386/cpu.h>
+#include <i386/x86.h>
+#include <kernel/ohwes.h>
 
 void memcmp_demo(const char* lhs, const char* rhs, size_t sz)
 {
@@ -206,6 +209,377 @@ void test_memcmp(void)
     #undef SETUP
 }
 
+//
+// exhaustive checks over every head/tail alignment combination; the rep
+// string paths only kick in for larger counts, so go well past that
+//
+
+#define _MAX_LEN    72
+#define _GUARD      0xEE
+
+static unsigned char _src[_MAX_LEN + 16];
+static unsigned char _dst[_MAX_LEN + 16];
+static unsigned char _big[3 * _MAX_LEN];
+static unsigned char _ref[3 * _MAX_LEN];
+
+static void fill_pattern(unsigned char *buf, size_t count, int seed)
+{
+    for (size_t i = 0; i < count; i++) {
+        buf[i] = (unsigned char) (seed + i * 7);
+    }
+}
+
+void test_memcpy_align(void)
+{
+    for (int so = 0; so < 4; so++) {
+        for (int d = 0; d < 4; d++) {
+            for (int n = 0; n <= _MAX_LEN; n++) {
+                fill_pattern(_src, sizeof(_src), n);
+                memset(_dst, _GUARD, sizeof(_dst));
+                VERIFY_ARE_EQUAL(&_dst[d + 4], memcpy(&_dst[d + 4], &_src[so], n));
+                for (int i = 0; i < sizeof(_dst); i++) {
+                    int exp = (i >= d + 4 && i < d + 4 + n) ? _src[so + i - (d + 4)] : _GUARD;
+                    VERIFY_ARE_EQUAL(exp, _dst[i]);
+                }
+            }
+        }
+    }
+}
+
+void test_memmove_overlap(void)
+{
+    for (int shift = -9; shift <= 9; shift++) {
+        for (int n = 0; n <= _MAX_LEN; n++) {
+            fill_pattern(_big, sizeof(_big), n);
+            memcpy(_ref, _big, sizeof(_ref));
+            for (int i = 0; i < n; i++) {
+                _ref[_MAX_LEN + shift + i] = _big[_MAX_LEN + i];
+            }
+            memmove(&_big[_MAX_LEN + shift], &_big[_MAX_LEN], n);
+            for (int i = 0; i < sizeof(_big); i++) {
+                VERIFY_ARE_EQUAL(_ref[i], _big[i]);
+            }
+        }
+    }
+}
+
+void test_memset_align(void)
+{
+    for (int d = 0; d < 4; d++) {
+        for (int n = 0; n <= _MAX_LEN; n++) {
+            memset(_dst, _GUARD, sizeof(_dst));
+            VERIFY_ARE_EQUAL(&_dst[d + 4], memset(&_dst[d + 4], 0x180 + n, n));
+            for (int i = 0; i < sizeof(_dst); i++) {
+                int exp = (i >= d + 4 && i < d + 4 + n) ? (unsigned char) (0x80 + n) : _GUARD;
+                VERIFY_ARE_EQUAL(exp, _dst[i]);
+            }
+        }
+    }
+}
+
+void test_memcmp_align(void)
+{
+    // bytes compare as unsigned char, wherever the difference is
+    for (int n = 1; n <= _MAX_LEN; n++) {
+        for (int k = 0; k < n; k++) {
+            fill_pattern(_src, n, 3);
+            fill_pattern(&_dst[1], n, 3);
+            VERIFY_IS_ZERO(memcmp(_src, &_dst[1], n));
+            _src[k] = 0x80;
+            _dst[1 + k] = 0x01;
+            VERIFY_IS_TRUE(memcmp(_src, &_dst[1], n) > 0);
+            VERIFY_IS_TRUE(memcmp(&_dst[1], _src, n) < 0);
+            VERIFY_IS_ZERO(memcmp(_src, &_dst[1], k));
+        }
+    }
+}
+
+//
+// the word-at-a-time scanners, over every starting alignment and lengths up
+// to a page; string bytes run from 0x41 to 0xFE so the high bit gets a workout
+//
+
+#define _SCAN_MAX   4096
+#define _SCAN_CYCLE 190
+
+static char _str[_SCAN_MAX + 8];
+static char _str2[_SCAN_MAX + 8];
+
+static void make_string(char *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++) {
+        buf[i] = (char) (0x41 + (i % _SCAN_CYCLE));
+    }
+    buf[len] = '\0';
+}
+
+static void check_scan(int align, size_t len)
+{
+    char *s = &_str[align];
+    make_string(s, len);
+
+    VERIFY_ARE_EQUAL(len, strlen(s));
+    VERIFY_ARE_EQUAL(0, strnlen(s, 0));
+    VERIFY_ARE_EQUAL(len, strnlen(s, len));
+    VERIFY_ARE_EQUAL(len, strnlen(s, len + 5));
+    VERIFY_ARE_EQUAL(len, strnlen(s, SIZE_MAX));
+    if (len > 0) {
+        VERIFY_ARE_EQUAL(len - 1, strnlen(s, len - 1));
+    }
+
+    VERIFY_IS_NULL(memchr(s, '\0', len));
+    VERIFY_ARE_EQUAL(&s[len], memchr(s, '\0', len + 1));
+    VERIFY_ARE_EQUAL(&s[len], strchr(s, '\0'));
+    VERIFY_IS_NULL(strchr(s, 0x01));
+    if (len > 0) {
+        size_t k = len - 1;
+        VERIFY_ARE_EQUAL(&s[k % _SCAN_CYCLE], memchr(s, s[k], len));
+        VERIFY_ARE_EQUAL(&s[k % _SCAN_CYCLE], strchr(s, s[k]));
+        VERIFY_IS_NULL(memchr(s, s[k], k % _SCAN_CYCLE));
+
+        // a byte with the high bit set; make_string() never emits 0xFF
+        size_t m = len / 2;
+        char save = s[m];
+        s[m] = (char) 0xFF;
+        VERIFY_ARE_EQUAL(&s[m], memchr(s, 0xFF, len));
+        VERIFY_IS_NULL(memchr(s, 0xFF, m));
+        VERIFY_ARE_EQUAL(&s[m], strchr(s, 0xFF));
+        VERIFY_ARE_EQUAL(&s[m], strchr(s, (char) 0xFF));
+        s[m] = save;
+    }
+
+    for (int b = 0; b < 4; b++) {
+        char *t = &_str2[b];
+        memcpy(t, s, len + 1);
+        VERIFY_IS_ZERO(strcmp(s, t));
+        VERIFY_IS_ZERO(strncmp(s, t, len));
+        VERIFY_IS_ZERO(strncmp(s, t, len + 3));
+        if (len > 0) {
+            // last byte differs; 0xC1 and up compare above 0x41 and up
+            t[len - 1] ^= 0x80;
+            int sign = ((unsigned char) s[len - 1] > (unsigned char) t[len - 1]) ? 1 : -1;
+            VERIFY_ARE_EQUAL(sign, strcmp(s, t) > 0 ? 1 : -1);
+            VERIFY_ARE_EQUAL(-sign, strcmp(t, s) > 0 ? 1 : -1);
+            VERIFY_ARE_EQUAL(sign, strncmp(s, t, len) > 0 ? 1 : -1);
+            VERIFY_IS_ZERO(strncmp(s, t, len - 1));
+
+            // shorter string compares less
+            t[len - 1] = '\0';
+            VERIFY_IS_TRUE(strcmp(s, t) > 0);
+            VERIFY_IS_TRUE(strcmp(t, s) < 0);
+        }
+    }
+}
+
+void test_string_scan(void)
+{
+    static const size_t lengths[] = {
+        127, 128, 129, 255, 256, 257, 1023, 1024, 1025,
+        _SCAN_MAX - 3, _SCAN_MAX - 2, _SCAN_MAX - 1, _SCAN_MAX
+    };
+
+    for (int align = 0; align < 4; align++) {
+        for (size_t len = 0; len <= _MAX_LEN; len++) {
+            check_scan(align, len);
+        }
+        for (int i = 0; i < countof(lengths); i++) {
+            check_scan(align, lengths[i]);
+        }
+    }
+}
+
+//
+// cycle counts against the old byte-at-a-time loops; the reference versions
+// must not be turned back into calls to the functions they are compared to
+//
+
+#define _BENCH_ITER     64
+#define _BENCH_MAX      4096
+
+static unsigned char _bench_src[_BENCH_MAX + 4];
+static unsigned char _bench_dst[_BENCH_MAX + 4];
+static volatile int _bench_sink;
+
+static __noloopcall void * byte_memcpy(void *dst, const void *src, size_t count)
+{
+    char *d = dst;
+    const char *s = src;
+    while (count--) {
+        *d++ = *s++;
+    }
+    return dst;
+}
+
+static __noloopcall void * byte_memmove(void *dst, const void *src, size_t count)
+{
+    char *d = (char *) dst + count;
+    const char *s = (const char *) src + count;
+    while (count--) {
+        *--d = *--s;
+    }
+    return dst;
+}
+
+static __noloopcall void * byte_memset(void *dst, int c, size_t count)
+{
+    char *d = dst;
+    while (count--) {
+        *d++ = (char) c;
+    }
+    return dst;
+}
+
+static __noloopcall int byte_memcmp(const void *lhs, const void *rhs, size_t count)
+{
+    const unsigned char *l = lhs;
+    const unsigned char *r = rhs;
+    while (count && *l == *r) {
+        l++; r++; count--;
+    }
+    return (count) ? *l - *r : 0;
+}
+
+static size_t byte_strlen(const char *str)
+{
+    size_t len = 0;
+    while (*str++ != '\0') {
+        len++;
+    }
+    return len;
+}
+
+static size_t byte_strnlen(const char *str, size_t maxlen)
+{
+    size_t len = 0;
+    while (maxlen-- && *str++ != '\0') {
+        len++;
+    }
+    return len;
+}
+
+static int byte_strcmp(const char *lhs, const char *rhs)
+{
+    while (*lhs && (*lhs == *rhs)) {
+        lhs++; rhs++;
+    }
+    return *(const unsigned char *) lhs - *(const unsigned char *) rhs;
+}
+
+static void * byte_memchr(const void *ptr, int c, size_t count)
+{
+    const unsigned char *p = ptr;
+    for (; count != 0; p++, count--) {
+        if (*p == (unsigned char) c) {
+            return (void *) p;
+        }
+    }
+    return NULL;
+}
+
+static char * byte_strchr(const char *str, int c)
+{
+    for (; *str != (char) c; str++) {
+        if (*str == '\0') {
+            return NULL;
+        }
+    }
+    return (char *) str;
+}
+
+enum bench_op {
+    _MEMCPY, _MEMMOVE, _MEMSET, _MEMCMP,
+    _STRLEN, _STRNLEN, _STRCMP, _MEMCHR, _STRCHR,
+    _NR_BENCH_OPS
+};
+
+static uint32_t bench_op(enum bench_op op, bool fast, size_t size, int offset)
+{
+    unsigned char *dst = &_bench_dst[offset];
+    unsigned char *src = &_bench_src[0];
+    uint64_t start, end;
+
+    // memmove runs overlapped to force the backwards copy
+    if (op == _MEMMOVE) {
+        src = &_bench_dst[0];
+        dst = &_bench_dst[offset + 4];
+        size -= 4;
+    }
+
+    // the scanning functions run to the end of a 'size'-byte string
+    if (op >= _STRLEN) {
+        dst[size - 1] = '\0';
+        src[size - 1] = '\0';
+    }
+
+    rdtsc(start);
+    for (int i = 0; i < _BENCH_ITER; i++) {
+        __asm__ volatile ("" : : : "memory");   // no hoisting the calls out
+        switch (op) {
+            case _MEMCPY:
+                (fast) ? memcpy(dst, src, size) : byte_memcpy(dst, src, size);
+                break;
+            case _MEMMOVE:
+                (fast) ? memmove(dst, src, size) : byte_memmove(dst, src, size);
+                break;
+            case _MEMSET:
+                (fast) ? memset(dst, i, size) : byte_memset(dst, i, size);
+                break;
+            case _MEMCMP:
+                _bench_sink += (fast) ? memcmp(dst, src, size) : byte_memcmp(dst, src, size);
+                break;
+            case _STRLEN:
+                _bench_sink += (fast) ? strlen((char *) dst) : byte_strlen((char *) dst);
+                break;
+            case _STRNLEN:
+                _bench_sink += (fast) ? strnlen((char *) dst, size) : byte_strnlen((char *) dst, size);
+                break;
+            case _STRCMP:
+                _bench_sink += (fast) ? strcmp((char *) dst, (char *) src) : byte_strcmp((char *) dst, (char *) src);
+                break;
+            case _MEMCHR:
+                _bench_sink += (fast) ? !!memchr(dst, 0, size) : !!byte_memchr(dst, 0, size);
+                break;
+            case _STRCHR:
+                _bench_sink += (fast) ? !!strchr((char *) dst, 'Z') : !!byte_strchr((char *) dst, 'Z');
+                break;
+            default:
+                break;
+        }
+    }
+    rdtsc(end);
+
+    return (uint32_t) ((end - start) / _BENCH_ITER);
+}
+
+void bench_string_functions(void)
+{
+    static const char *names[] = {
+        "memcpy", "memmove", "memset", "memcmp",
+        "strlen", "strnlen", "strcmp", "memchr", "strchr"
+    };
+    static const size_t sizes[] = { 16, 64, 256, 1024, _BENCH_MAX };
+    struct cpuid cpu;
+
+    if (!get_cpu_info(&cpu) || !cpu.tsc_support) {
+        return;
+    }
+
+    tprint("%-8s %5s %3s %8s %8s  (cycles)\n", "func", "size", "off", "byte", "fast");
+    for (int op = 0; op < _NR_BENCH_OPS; op++) {
+        for (int i = 0; i < countof(sizes); i++) {
+            for (int offset = 0; offset < 2; offset++) {
+                memset(_bench_src, 'A', sizeof(_bench_src));
+                memset(_bench_dst, 'A', sizeof(_bench_dst));
+                uint32_t slow = bench_op(op, false, sizes[i], offset);
+                memset(_bench_src, 'A', sizeof(_bench_src));
+                memset(_bench_dst, 'A', sizeof(_bench_dst));
+                uint32_t fast = bench_op(op, true, sizes[i], offset);
+                tprint("%-8s %5d %3d %8d %8d\n", names[op], sizes[i], offset, slow, fast);
+            }
+        }
+    }
+}
+
 void test_strcmp(void)
 {
     char *a;
@@ -379,12 +753,19 @@ void test_string(void)
     test_memcpy();
     test_memmove();
     test_memcmp();
+    test_memcpy_align();
+    test_memmove_overlap();
+    test_memset_align();
+    test_memcmp_align();
     test_strcmp();
     test_strncmp();
     test_strlen();
     test_strnlen();
+    test_string_scan();
     test_strcpy();
     test_strncpy();
     test_strcat();
     test_strncat();
+
+    bench_string_functions();
 }
@@ -0,0 +1,82 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: kernel/test/test_trace.c
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * =============================================================================
+ */
+
+#include <test.h>
+#include <kernel/kernel.h>
+#include <kernel/ohwes.h>
+#include <kernel/trace.h>
+
+#define _NR_EXTRA   5
+
+static struct trace_record _recs[4];
+
+static void drain(void)
+{
+    while (trace_read(_recs, countof(_recs)) != 0) { }
+}
+
+void test_trace(void)
+{
+    DECLARE_TEST("tracing");
+
+    bool was_on = g_trace_on;
+
+    // nothing is recorded while stopped
+    trace_stop();
+    drain();
+    trace("test: stopped");
+    VERIFY_ARE_EQUAL(0, trace_read(_recs, countof(_recs)));
+
+#if TRACING
+    // records come back oldest first with their arguments intact
+    trace_start();
+    trace("test: a %d %d %d %d %d", 10, 11, 12, 13, 14);
+    trace("test: b");
+    trace("test: c %pS", test_trace);
+    trace_stop();
+    VERIFY_ARE_EQUAL(3, trace_read(_recs, countof(_recs)));
+    VERIFY_ARE_NOT_EQUAL(0, _recs[0].event);
+    VERIFY_ARE_NOT_EQUAL(_recs[0].event, _recs[1].event);
+    for (int i = 0; i < TRACE_NR_ARGS; i++) {
+        VERIFY_ARE_EQUAL(10 + i, _recs[0].args[i]);
+        VERIFY_ARE_EQUAL(0, _recs[1].args[i]);
+    }
+    VERIFY_ARE_EQUAL((uint32_t) test_trace, _recs[2].args[0]);
+    VERIFY_IS_TRUE(_recs[0].tsc < _recs[1].tsc);
+    VERIFY_IS_TRUE(_recs[1].tsc < _recs[2].tsc);
+    VERIFY_ARE_EQUAL(0, trace_read(_recs, countof(_recs)));
+
+    // wrapping the ring drops the oldest records; __trace records regardless
+    // of whether tracing is started
+    size_t dropped = trace_dropped();
+    for (int i = 0; i < NR_TRACE_RECORDS + _NR_EXTRA; i++) {
+        __trace(0xBEEF, i, 0, 0, 0, 0);
+    }
+    VERIFY_ARE_EQUAL(dropped + _NR_EXTRA, trace_dropped());
+    VERIFY_ARE_EQUAL(1, trace_read(_recs, 1));
+    VERIFY_ARE_EQUAL(_NR_EXTRA, _recs[0].args[0]);
+    drain();
+#endif
+
+    if (was_on) {
+        trace_start();
+    }
+}
@@ -0,0 +1,304 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: kernel/test/test_tty.c
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * =============================================================================
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <test.h>
+#include <i386/cpu.h>
+#include <i386/x86.h>
+#include <kernel/fs.h>
+#include <kernel/ohwes.h>
+#include <kernel/tty.h>
+
+#define _LINE_LEN       64
+#define _NR_LINES       64
+#define _BENCH_SIZE     (_LINE_LEN * _NR_LINES)
+
+extern int tty_open_internal(struct tty *tty);
+
+static char _buf[_BENCH_SIZE];
+static char _out[_BENCH_SIZE * 2];
+static size_t _nout;
+static int _nwrites;
+
+static int stub_write(struct tty *tty, const char *buf, size_t count)
+{
+    memcpy(&_out[_nout], buf, count);
+    _nout += count;
+    _nwrites++;
+    return count;
+}
+
+static size_t stub_write_room(struct tty *tty)
+{
+    return sizeof(_out) - _nout;
+}
+
+static void fill_lines(char *buf, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        buf[i] = ((i % _LINE_LEN) == _LINE_LEN - 1) ? '\n' : 'a' + (i % 26);
+    }
+}
+
+static struct tty * open_tty(dev_t device)
+{
+    struct tty *tty;
+
+    if (get_tty(device, &tty) || tty_open_internal(tty)) {
+        return NULL;
+    }
+    return tty;
+}
+
+void test_tty_opost(void)
+{
+    static struct tty tty;
+    struct tty *vt;
+
+    vt = open_tty(__mkttydev(1));
+    VERIFY_IS_NOT_NULL(vt);
+
+    tty.ldisc = vt->ldisc;
+    tty.driver.write = stub_write;
+    tty.driver.write_room = stub_write_room;
+    tty.termios.c_oflag = OPOST | ONLCR;
+
+    // NL becomes CR-NL; the text between them goes out in one driver call
+    fill_lines(_buf, sizeof(_buf));
+    _nout = 0; _nwrites = 0;
+    VERIFY_ARE_EQUAL(_BENCH_SIZE, tty.ldisc->write(&tty, _buf, sizeof(_buf)));
+    VERIFY_ARE_EQUAL(_BENCH_SIZE + _NR_LINES, _nout);
+    VERIFY_IS_TRUE(_nwrites <= 3 * _NR_LINES);
+    for (int i = 0; i < _NR_LINES; i++) {
+        const char *line = &_out[i * (_LINE_LEN + 1)];
+        VERIFY_IS_ZERO(memcmp(line, &_buf[i * _LINE_LEN], _LINE_LEN - 1));
+        VERIFY_ARE_EQUAL('\r', line[_LINE_LEN - 1]);
+        VERIFY_ARE_EQUAL('\n', line[_LINE_LEN]);
+    }
+
+    // CR becomes NL
+    tty.termios.c_oflag = OPOST | OCRNL;
+    _nout = 0;
+    VERIFY_ARE_EQUAL(5, tty.ldisc->write(&tty, "a\rb\nc", 5));
+    VERIFY_ARE_EQUAL(5, _nout);
+    VERIFY_IS_ZERO(memcmp(_out, "a\nb\nc", 5));
+
+    // no post processing, one driver call
+    tty.termios.c_oflag = ONLCR;
+    _nout = 0; _nwrites = 0;
+    VERIFY_ARE_EQUAL(_BENCH_SIZE, tty.ldisc->write(&tty, _buf, sizeof(_buf)));
+    VERIFY_ARE_EQUAL(_BENCH_SIZE, _nout);
+    VERIFY_ARE_EQUAL(1, _nwrites);
+}
+
+static void recv_str(struct tty *tty, const char *s)
+{
+    tty->ldisc->recv(tty, s, NULL, strlen(s));
+}
+
+// receive a line of 'len' chars, newline included
+static void recv_line(struct tty *tty, size_t len)
+{
+    memset(_buf, 'x', len - 1);
+    _buf[len - 1] = '\n';
+    tty->ldisc->recv(tty, _buf, NULL, len);
+}
+
+static void verify_read(struct tty *tty, const char *expected, size_t count)
+{
+    char buf[TTY_LINE_MAX + 1];
+    ssize_t len = strlen(expected);
+
+    VERIFY_ARE_EQUAL(len, tty->ldisc->read(tty, buf, count));
+    VERIFY_IS_ZERO(memcmp(buf, expected, len));
+}
+
+void test_tty_canon(void)
+{
+    static struct tty tty;
+    static struct file file;
+    char buf[TTY_LINE_MAX + 1];
+    struct tty *vt;
+    int nlines;
+
+    vt = open_tty(__mkttydev(1));
+    VERIFY_IS_NOT_NULL(vt);
+
+    // tty0 is never opened, so its line discipline data is free to use
+    tty.device = __mkdev(TTY_MAJOR, 0);
+    tty.file = &file;
+    tty.termios = vt->termios;
+    tty.termios.c_oflag = 0;
+    tty.termios.c_lflag = ICANON;
+    tty.ldisc = vt->ldisc;
+    tty.driver.write = stub_write;
+    tty.driver.write_room = stub_write_room;
+    file.f_oflag = O_NONBLOCK;
+    VERIFY_IS_ZERO(tty.ldisc->open(&tty));
+
+    // nothing until a line is committed
+    VERIFY_ARE_EQUAL(-EAGAIN, tty.ldisc->read(&tty, buf, sizeof(buf)));
+    recv_str(&tty, "abc");
+    VERIFY_ARE_EQUAL(-EAGAIN, tty.ldisc->read(&tty, buf, sizeof(buf)));
+    recv_str(&tty, "\n");
+    verify_read(&tty, "abc\n", sizeof(buf));
+
+    // ERASE, WERASE and KILL
+    recv_str(&tty, "ab\x7F" "c\n");
+    verify_read(&tty, "ac\n", sizeof(buf));
+    recv_str(&tty, "one two  \x17three\n");
+    verify_read(&tty, "one three\n", sizeof(buf));
+    recv_str(&tty, "junk\x15ok\n");
+    verify_read(&tty, "ok\n", sizeof(buf));
+    recv_str(&tty, "\x7F\x17\x15x\n");
+    verify_read(&tty, "x\n", sizeof(buf));
+
+    // ERASE is echoed as-is without ECHOE...
+    tty.termios.c_lflag = ICANON | ECHO;
+    _nout = 0;
+    recv_str(&tty, "ab\x7F\n");
+    verify_read(&tty, "a\n", sizeof(buf));
+    VERIFY_ARE_EQUAL(4, _nout);
+    VERIFY_IS_ZERO(memcmp(_out, "ab\x7F\n", 4));
+
+    // ...and rubs out the char with it
+    tty.termios.c_lflag = ICANON | ECHO | ECHOE;
+    _nout = 0;
+    recv_str(&tty, "ab\x7F\n");
+    verify_read(&tty, "a\n", sizeof(buf));
+    VERIFY_ARE_EQUAL(6, _nout);
+    VERIFY_IS_ZERO(memcmp(_out, "ab\b \b\n", 6));
+    _nout = 0;
+    recv_str(&tty, "a b\x15\n");
+    verify_read(&tty, "\n", sizeof(buf));
+    VERIFY_ARE_EQUAL(13, _nout);
+    VERIFY_IS_ZERO(memcmp(_out, "a b\b \b\b \b\b \b\n", 13));
+
+    // EOF alone reads as EOF, EOF after a partial line ends it
+    recv_str(&tty, "\x04");
+    VERIFY_ARE_EQUAL(0, tty.ldisc->read(&tty, buf, sizeof(buf)));
+    VERIFY_ARE_EQUAL(-EAGAIN, tty.ldisc->read(&tty, buf, sizeof(buf)));
+    recv_str(&tty, "ab\x04");
+    verify_read(&tty, "ab", sizeof(buf));
+    VERIFY_ARE_EQUAL(-EAGAIN, tty.ldisc->read(&tty, buf, sizeof(buf)));
+
+    // a line can be read in pieces, but a read never spans lines
+    recv_str(&tty, "hello world\nbye\n");
+    verify_read(&tty, "hello", 5);
+    verify_read(&tty, " worl", 5);
+    verify_read(&tty, "d\n", 5);
+    verify_read(&tty, "bye\n", sizeof(buf));
+
+    // a full line takes nothing but a newline
+    memset(_buf, 'x', TTY_LINE_MAX - 1);
+    tty.ldisc->recv(&tty, _buf, NULL, TTY_LINE_MAX - 1);
+    _nout = 0;
+    recv_str(&tty, "y\n");
+    VERIFY_ARE_EQUAL(2, _nout);
+    VERIFY_IS_ZERO(memcmp(_out, "\a\n", 2));
+    VERIFY_ARE_EQUAL(TTY_LINE_MAX, tty.ldisc->read(&tty, buf, sizeof(buf)));
+    VERIFY_ARE_EQUAL('x', buf[TTY_LINE_MAX - 2]);
+    VERIFY_ARE_EQUAL('\n', buf[TTY_LINE_MAX - 1]);
+
+    // a full queue takes nothing, not even an EOF
+    nlines = TTY_BUFFER_SIZE / (TTY_LINE_MAX + 1);
+    for (int i = 0; i < nlines; i++) {
+        recv_line(&tty, TTY_LINE_MAX);
+    }
+    VERIFY_ARE_EQUAL(0, tty.ldisc->recv_room(&tty));
+    _nout = 0;
+    recv_str(&tty, "\x04" "a\n");
+    VERIFY_ARE_EQUAL(3, _nout);
+    VERIFY_IS_ZERO(memcmp(_out, "\a\a\a", 3));
+    VERIFY_ARE_EQUAL(TTY_LINE_MAX, tty.ldisc->read(&tty, buf, sizeof(buf)));
+    recv_str(&tty, "\x04");
+    for (int i = 1; i < nlines; i++) {
+        VERIFY_ARE_EQUAL(TTY_LINE_MAX, tty.ldisc->read(&tty, buf, sizeof(buf)));
+    }
+    VERIFY_ARE_EQUAL(0, tty.ldisc->read(&tty, buf, sizeof(buf)));
+    VERIFY_ARE_EQUAL(-EAGAIN, tty.ldisc->read(&tty, buf, sizeof(buf)));
+
+    tty.ldisc->close(&tty);
+}
+
+static void bench_write(dev_t device)
+{
+    struct tty *tty;
+    uint64_t start, end;
+    size_t count;
+    ssize_t n;
+    char name[16];
+    int minor;
+
+    // name it the way its /dev node is named; serial ports count from 1
+    minor = _DEV_MIN(device);
+    if (minor <= TTY_MAX) {
+        snprintf(name, sizeof(name), "tty%d", minor);
+    }
+    else {
+        snprintf(name, sizeof(name), "ttyS%d", minor - TTYS_MIN + 1);
+    }
+
+    tty = open_tty(device);
+    if (!tty || !O_OPOST(tty)) {
+        tprint("%-8s %8s\n", name, "n/a");
+        return;
+    }
+
+    // stay under the driver's buffer so we time the tty layers, not the wire
+    count = min(sizeof(_buf), tty->driver.write_room(tty) / 2);
+
+    rdtsc(start);
+    n = tty->ldisc->write(tty, _buf, count);
+    rdtsc(end);
+
+    if (n <= 0) {
+        tprint("%-8s %8s\n", name, "n/a");
+        return;
+    }
+    tprint("%-8s %8d %8d\n", name, (int) n, (int) ((end - start) / n));
+}
+
+void bench_tty_write(void)
+{
+    struct cpuid cpu;
+
+    if (!get_cpu_info(&cpu) || !cpu.tsc_support) {
+        return;
+    }
+
+    fill_lines(_buf, sizeof(_buf));
+    tprint("%-8s %8s %8s  (OPOST|ONLCR)\n", "tty", "bytes", "cyc/byte");
+    bench_write(__mkserdev(1));
+    bench_write(__mkttydev(2));
+}
+
+void test_tty(void)
+{
+    DECLARE_TEST("tty");
+
+    test_tty_opost();
+    test_tty_canon();
+    bench_tty_write();
+}
@@ -0,0 +1,72 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: kernel/test/test_wait.c
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * =============================================================================
+ */
+
+#include <test.h>
+#include <i386/interrupt.h>
+#include <i386/x86.h>
+#include <kernel/irq.h>
+#include <kernel/wait.h>
+
+#define _NR_TICKS   3
+
+static struct wait_queue _wq;
+static volatile int _ticks;
+
+static void tick_irq(int irq, struct iregs *regs)
+{
+    if (_ticks < _NR_TICKS) {
+        _ticks++;
+        wake_up(&_wq);
+    }
+}
+
+void test_wait(void)
+{
+    DECLARE_TEST("wait queues");
+
+    struct eflags before, after;
+
+    // a true condition returns right away with the interrupt flag intact
+    init_wait_queue(&_wq);
+    cli_save(before);
+    wait_event(&_wq, true);
+    cli_save(after);
+    restore_flags(before);
+    VERIFY_ARE_EQUAL(0, after.intf);
+    VERIFY_ARE_EQUAL(0, _wq.nr_waiters);
+    VERIFY_ARE_EQUAL(0, _wq.wakeups);
+
+    wake_up(&_wq);
+    VERIFY_ARE_EQUAL(1, _wq.wakeups);
+
+    // sleep across a few timer ticks, if the timer is running
+    if (irq_getmask() & (1 << IRQ_TIMER)) {
+        return;
+    }
+    init_wait_queue(&_wq);
+    _ticks = 0;
+    irq_register(IRQ_TIMER, tick_irq);
+    wait_event(&_wq, _ticks == _NR_TICKS);
+    irq_unregister(IRQ_TIMER, tick_irq);
+    VERIFY_ARE_EQUAL(_NR_TICKS, _ticks);
+    VERIFY_ARE_EQUAL(_NR_TICKS, _wq.wakeups);
+    VERIFY_ARE_EQUAL(0, _wq.nr_waiters);
+}
@@ -0,0 +1,186 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: kernel/trace.c
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * -----------------------------------------------------------------------------
+ * Binary event tracing. Tracepoints drop fixed-size records into a ring buffer
+ * that overwrites the oldest records when it wraps. The buffer can be drained
+ * through /dev/trace or dumped to the console, and is decoded on the host with
+ * tools/tracedump.
+ * =============================================================================
+ */
+
+#include <errno.h>
+#include <string.h>
+#include <i386/cpu.h>
+#include <i386/interrupt.h>
+#include <i386/x86.h>
+#include <kernel/char.h>
+#include <kernel/device.h>
+#include <kernel/fs.h>
+#include <kernel/kernel.h>
+#include <kernel/ohwes.h>
+#include <kernel/trace.h>
+
+static_assert((NR_TRACE_RECORDS & (NR_TRACE_RECORDS - 1)) == 0,
+    "NR_TRACE_RECORDS must be a power of 2");
+
+static struct trace_record _trace_buf[NR_TRACE_RECORDS];
+static uint32_t _trace_head;    // number of records written, ever
+static uint32_t _trace_tail;    // number of records read or lost, ever
+static size_t _trace_dropped;   // records overwritten before they were read
+static bool _trace_tsc;         // timestamp with RDTSC
+
+bool g_trace_on;
+
+static int trace_open(struct inode *inode, struct file *file);
+static ssize_t trace_fread(struct file *file, char *buf, size_t count);
+
+static struct file_ops trace_fops = {
+    .open = trace_open,
+    .close = NULL,
+    .read = trace_fread,
+    .write = NULL,
+    .ioctl = NULL
+};
+
+void init_trace(void)
+{
+    struct cpuid cpu;
+    if (get_cpu_info(&cpu)) {
+        _trace_tsc = cpu.tsc_support;
+    }
+
+    int ret = register_chdev(TRACE_MAJOR, "trace", &trace_fops);
+    if (ret < 0) {
+        panic("failed to register trace device! (%d)", ret);
+    }
+
+#if TRACING
+    trace_start();
+#endif
+}
+
+void __trace(uint32_t event, uint32_t a0, uint32_t a1, uint32_t a2, uint32_t a3, uint32_t a4)
+{
+    uint32_t flags;
+    struct trace_record *rec;
+
+    cli_save(flags);
+
+    rec = &_trace_buf[_trace_head & (NR_TRACE_RECORDS - 1)];
+    if (_trace_tsc) {
+        rdtsc(rec->tsc);
+    }
+    else {
+        rec->tsc = _trace_head;
+    }
+    rec->event = event;
+    rec->args[0] = a0;
+    rec->args[1] = a1;
+    rec->args[2] = a2;
+    rec->args[3] = a3;
+    rec->args[4] = a4;
+
+    // overwrite the oldest record if the reader hasn't kept up
+    if (++_trace_head - _trace_tail > NR_TRACE_RECORDS) {
+        _trace_tail++;
+        _trace_dropped++;
+    }
+
+    restore_flags(flags);
+}
+
+void trace_start(void)
+{
+    g_trace_on = true;
+}
+
+void trace_stop(void)
+{
+    g_trace_on = false;
+}
+
+size_t trace_read(struct trace_record *buf, size_t count)
+{
+    uint32_t flags;
+    size_t n;
+
+    cli_save(flags);
+
+    n = min(count, (size_t) (_trace_head - _trace_tail));
+    for (size_t i = 0; i < n; i++) {
+        buf[i] = _trace_buf[_trace_tail++ & (NR_TRACE_RECORDS - 1)];
+    }
+
+    restore_flags(flags);
+    return n;
+}
+
+size_t trace_dropped(void)
+{
+    return _trace_dropped;
+}
+
+void trace_dump(void)
+{
+    bool was_on = g_trace_on;
+    uint32_t start, end;
+
+    // hold still while we print
+    trace_stop();
+
+    end = _trace_head;
+    start = end - min(end, (uint32_t) NR_TRACE_RECORDS);
+
+    kprint("trace: begin %d records, tsc=%d\n", end - start, _trace_tsc);
+    for (uint32_t i = start; i != end; i++) {
+        struct trace_record *rec = &_trace_buf[i & (NR_TRACE_RECORDS - 1)];
+        kprint("trace: %016llX %08X %08X %08X %08X %08X %08X\n",
+            rec->tsc, rec->event, rec->args[0], rec->args[1],
+            rec->args[2], rec->args[3], rec->args[4]);
+    }
+    kprint("trace: end\n");
+
+    if (was_on) {
+        trace_start();
+    }
+}
+
+static int trace_open(struct inode *inode, struct file *file)
+{
+    if (!inode || !file) {
+        return -EINVAL;
+    }
+
+    file->fops = &trace_fops;
+    file->inode = inode;
+    file->private_data = NULL;
+
+    return 0;
+}
+
+static ssize_t trace_fread(struct file *file, char *buf, size_t count)
+{
+    if (count < sizeof(struct trace_record)) {
+        return -EINVAL;
+    }
+
+    // whole records only
+    size_t n = trace_read((struct trace_record *) buf, count / sizeof(struct trace_record));
+    return n * sizeof(struct trace_record);
+}
@@ -0,0 +1,45 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: kernel/wait.c
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * =============================================================================
+ */
+
+#include <stddef.h>
+#include <kernel/config.h>
+#include <kernel/mm.h>
+#include <kernel/wait.h>
+
+void init_wait_queue(struct wait_queue *wq)
+{
+    wq->wakeups = 0;
+    wq->nr_waiters = 0;
+}
+
+void wake_up(struct wait_queue *wq)
+{
+    // the halted CPU is already running again by the time the interrupt
+    // handler gets here; this just tells the waiter to re-check its condition
+    wq->wakeups++;
+}
+
+void idle_work(void)
+{
+    // keep the zeroed page reserve stocked so ALLOC_ZERO doesn't have to zero
+    // inline; a page or two at a time keeps interrupt latency down
+    refill_zero_pages(ZERO_REFILL_BUDGET);
+}
@@ -6,3 +6,7 @@ SOURCES := \
     printf.c \
     stdio.c \
     string.c \
+
+# don't let GCC turn the byte loops in memcpy and friends into calls to memcpy
+# and friends
+TARGET_CFLAGS := -fno-tree-loop-distribute-patterns
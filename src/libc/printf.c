@@ -37,6 +37,7 @@
 
 #define PRINTF_BUFSIZ   1024
 #define NUM2STR_BUFSIZ  64
+#define PAD_RUN         16
 
 // lengths
 enum {
@@ -53,20 +54,26 @@ enum {
 struct printf_state
 {
     va_list args;               // format arguments
-    char *buffer;               // sprintf/snprintf buffer
-    size_t buffer_avail;        // snprintf num chars available in buffer
+    char *buffer;               // next free char in output buffer
+    size_t buffer_avail;        // printf/snprintf num chars available in buffer
+    char *buffer_start;         // printf buffer, for flushing
+    printf_sink sink;           // vcbprintf callback
+    void *sink_arg;             // vcbprintf callback argument
 };
 
-typedef int (*printf_fn)(struct printf_state *, char);
+// output sinks take a run of characters at a time, and return the number of
+// characters to count toward the printf return value
+typedef int (*printf_fn)(struct printf_state *, const char *, size_t);
 
-static int _printf_putc(struct printf_state *state, char c);
-static int _sprintf_putc(struct printf_state *state, char c);
-static int _snprintf_putc(struct printf_state *state, char c);
+static int _printf_write(struct printf_state *state, const char *s, size_t n);
+static int _sprintf_write(struct printf_state *state, const char *s, size_t n);
+static int _snprintf_write(struct printf_state *state, const char *s, size_t n);
+static int _cbprintf_write(struct printf_state *state, const char *s, size_t n);
 
 static int _doprintf(
     const char *format,
     struct printf_state *state,
-    printf_fn putc);
+    printf_fn emit);
 
 /**
  * "Writes the results to the output stream stdout."
@@ -95,9 +102,10 @@ int vprintf(const char *format, va_list args)
 
     state.args = args;
     state.buffer = buffer;
+    state.buffer_start = buffer;
     state.buffer_avail = sizeof(buffer);
-    nwritten = _doprintf(format, &state, _printf_putc);
-    write(STDOUT_FILENO, buffer, nwritten); // flush!
+    nwritten = _doprintf(format, &state, _printf_write);
+    write(STDOUT_FILENO, buffer, state.buffer - buffer);  // flush!
 
     return nwritten;
 }
@@ -121,12 +129,16 @@ int sprintf(char *buffer, const char *format, ...)
 
 int vsprintf(char *buffer, const char *format, va_list args)
 {
+    int nwritten;
     struct printf_state state = { };
 
     state.args = args;
     state.buffer = buffer;  // better be large enough! TODO: should alloc local
                             // buffer here and page fault if exceeded
-    return _doprintf(format, &state, _sprintf_putc);
+    nwritten = _doprintf(format, &state, _sprintf_write);
+    *state.buffer = '\0';
+
+    return nwritten;
 }
 
 /**
@@ -151,75 +163,197 @@ int snprintf(char *buffer, size_t bufsz, const char *format, ...)
 
 int vsnprintf(char *buffer, size_t bufsz, const char *format, va_list args)
 {
+    int nwritten;
     struct printf_state state = { };
 
     state.args = args;
     state.buffer = buffer;
-    state.buffer_avail = bufsz;
-    return _doprintf(format, &state, _snprintf_putc);
+    state.buffer_avail = (bufsz > 0) ? bufsz - 1 : 0;   // leave room for NUL
+    nwritten = _doprintf(format, &state, _snprintf_write);
+    if (bufsz > 0) {
+        *state.buffer = '\0';
+    }
+
+    return nwritten;
 }
 
-static int _printf_putc(struct printf_state *state, char c)
+int vcbprintf(printf_sink sink, void *arg, const char *format, va_list args)
 {
-    (void) state;
-
-    if (!state->buffer_avail) {
-        // write the current buffer to stdout
-        write(STDERR_FILENO, state->buffer, PRINTF_BUFSIZ);
-
-        // and reuse it for the next chunk
-        state->buffer_avail = PRINTF_BUFSIZ;
-        state->buffer -= state->buffer_avail;
-        c = '*';
-        write(STDOUT_FILENO, &c, 1);
-        for(;;);
+    struct printf_state state = { };
+
+    if (sink == NULL || format == NULL) {
+        return -EINVAL;
     }
 
-    // fill up the buffer; caller, don't forget to flush!
-    state->buffer_avail--;
-    return _sprintf_putc(state, c);
+    state.args = args;
+    state.sink = sink;
+    state.sink_arg = arg;
+    return _doprintf(format, &state, _cbprintf_write);
 }
 
-static int _sprintf_putc(struct printf_state *state, char c)
+static int _printf_write(struct printf_state *state, const char *s, size_t n)
 {
-    *state->buffer++ = c;
-    *state->buffer = '\0';
+    size_t count = n;
+
+    while (n > 0) {
+        if (!state->buffer_avail) {
+            // write the current buffer to stdout and reuse it for the next chunk
+            write(STDOUT_FILENO, state->buffer_start, PRINTF_BUFSIZ);
+            state->buffer = state->buffer_start;
+            state->buffer_avail = PRINTF_BUFSIZ;
+        }
 
-    return 1;
+        size_t chunk = (n < state->buffer_avail) ? n : state->buffer_avail;
+        memcpy(state->buffer, s, chunk);
+        state->buffer += chunk;
+        state->buffer_avail -= chunk;
+        s += chunk;
+        n -= chunk;
+    }
+
+    // caller, don't forget to flush!
+    return count;
 }
 
-static int _snprintf_putc(struct printf_state *state, char c)
+static int _sprintf_write(struct printf_state *state, const char *s, size_t n)
 {
-    if (state->buffer_avail > 0) {
-        // add char if there's space
-        state->buffer_avail--;
-        _sprintf_putc(state, c);
+    memcpy(state->buffer, s, n);
+    state->buffer += n;
+
+    return n;
+}
+
+static int _snprintf_write(struct printf_state *state, const char *s, size_t n)
+{
+    size_t chunk = (n < state->buffer_avail) ? n : state->buffer_avail;
+
+    // add chars if there's space
+    memcpy(state->buffer, s, chunk);
+    state->buffer += chunk;
+    state->buffer_avail -= chunk;
+
+    // always return the full count to keep track of chars that would've been
+    // written if buffer was large enough
+    return n;
+}
+
+static int _cbprintf_write(struct printf_state *state, const char *s, size_t n)
+{
+    return state->sink(state->sink_arg, s, n);
+}
+
+//
+// Number conversion. Digits are written right-to-left ending at 'end', and the
+// start of the digits is returned. Zero produces no digits; the default
+// precision of 1 takes care of printing it.
+//
+
+static const char _digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const char _digits[]     = "0123456789abcdef";
+static const char _digits_cap[] = "0123456789ABCDEF";
+
+static const char _spaces[PAD_RUN] = "                ";
+static const char _zeros[PAD_RUN]  = "0000000000000000";
+
+static char * _utoa_dec(char *end, uintmax_t num)
+{
+    char *p = end;
+    uint32_t n, q, r;
+
+    // 64-bit division is a libgcc call on i386, so only use it until the
+    // number fits in 32 bits
+    while (num > UINT32_MAX) {
+        uintmax_t q64 = num / 100;
+        r = (uint32_t) (num - q64 * 100);
+        p -= 2;
+        p[0] = _digit_pairs[2 * r];
+        p[1] = _digit_pairs[2 * r + 1];
+        num = q64;
     }
 
-    // always return 1 to keep track of chars that would've been written if
-    // buffer was large enough
-    return 1;
+    // two digits per division
+    n = (uint32_t) num;
+    while (n >= 100) {
+        q = n / 100;
+        r = n - q * 100;
+        p -= 2;
+        p[0] = _digit_pairs[2 * r];
+        p[1] = _digit_pairs[2 * r + 1];
+        n = q;
+    }
+    if (n >= 10) {
+        p -= 2;
+        p[0] = _digit_pairs[2 * n];
+        p[1] = _digit_pairs[2 * n + 1];
+    }
+    else if (n > 0) {
+        *--p = '0' + n;
+    }
+
+    return p;
+}
+
+static char * _utoa_pow2(char *end, uintmax_t num, int shift, const char *digits)
+{
+    const uint32_t mask = (1 << shift) - 1;
+    char *p = end;
+    uint32_t n;
+
+    while (num > UINT32_MAX) {
+        *--p = digits[num & mask];
+        num >>= shift;
+    }
+
+    // finish up in one register
+    n = (uint32_t) num;
+    while (n) {
+        *--p = digits[n & mask];
+        n >>= shift;
+    }
+
+    return p;
 }
 
 static int _doprintf(
     const char *format,
     struct printf_state *state,
-    printf_fn putc)
+    printf_fn emit)
 {
     int nwritten = 0;
     int retval = 0;
 
     // where the magic happens
 
-#define _putchar(c) \
+#define _emit(s,n) \
 do { \
-    retval = (*putc)(state, c); \
+    retval = (*emit)(state, s, n); \
     if (retval < 0) { \
         goto done; \
     } \
     nwritten += retval; \
 } while(0)
 
+#define _pad(run,n) \
+do { \
+    int _n = (n); \
+    while (_n > 0) { \
+        int _k = (_n < PAD_RUN) ? _n : PAD_RUN; \
+        _emit(run, _k); \
+        _n -= _k; \
+    } \
+} while (0)
+
     const char *format_start = format;
 
     while (format != NULL && *format != '\0')
@@ -242,19 +376,24 @@ do { \
         register char *p = NULL;
         char sign_char = 0;
 
-        char num2str[NUM2STR_BUFSIZ ];
+        char num2str[NUM2STR_BUFSIZ];
 
         uintmax_t num = 0;
 
         //
-        // next char
+        // literal text: write everything up to the next '%' in one go
         //
-        c = *format++;
-        if (c != '%') {
-            _putchar(c);
+        if (*format != '%') {
+            const char *run = format;
+            format = strchr(run, '%');
+            if (format == NULL) {
+                format = run + strlen(run);
+            }
+            _emit(run, format - run);
             continue;
         }
 
+        format++;
         format_start = format;
 
         //
@@ -384,18 +523,20 @@ do { \
             // strings: write then continue to top of loop
             //
             default: {  // invalid conversion char:
-                _putchar('%');  // abort! just write the format string
-                while (format_start < format) {
-                    _putchar(*format_start++);
+                if (c == '\0' && format[-1] == '\0') {
+                    format--;   // ran off the end; don't go past the NUL
                 }
+                _emit("%", 1);  // abort! just write the format string
+                _emit(format_start, format - format_start);
                 continue;
             }
             case '%': {
-                _putchar(c);
+                _emit("%", 1);
                 continue;
             }
             case 'c': {
-                _putchar((char) va_arg(state->args, int));
+                char ch = (char) va_arg(state->args, int);
+                _emit(&ch, 1);
                 continue;
             }
             case 's': {
@@ -405,28 +546,14 @@ do { \
                         str = "(null)";
                     }
 
-                    len = strlen(str);
-                    if (default_prec) {
-                        prec = len;
-                    }
-                    else {
-                        len = prec;
-                    }
+                    len = (default_prec) ? strlen(str) : strnlen(str, prec);
 
                     if (!ljustify) {
-                        while (width-- > prec) {
-                            _putchar(' ');
-                        }
-                    }
-
-                    while (len-- > 0 && *str != '\0') {
-                        _putchar(*str++);
+                        _pad(_spaces, width - len);
                     }
-
+                    _emit(str, len);
                     if (ljustify) {
-                        while (width-- > prec) {
-                            _putchar(' ');
-                        }
+                        _pad(_spaces, width - len);
                     }
                 }
                 else if (length == L_L) {
@@ -464,11 +591,11 @@ do { \
                     case L_Z:   n = va_arg(state->args, size_t); break;
                     case L_T:   n = va_arg(state->args, ptrdiff_t); break;
                 }
+                num = n;    // store unsigned
                 if (n < 0) {
                     negative = true;
-                    n = -n;
+                    num = -num;
                 }
-                num = n;    // store unsigned
                 break;
             }
             case 'u': {
@@ -490,31 +617,21 @@ do { \
         zero = (num == 0);
 
         // convert num to string
-
-        static char digits[]     = "0123456789abcdefghijklmnopqrstuvwxyz";
-        static char digits_cap[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
-
-
-        p = &num2str[NUM2STR_BUFSIZ-1];
-        while (num) {
-            if (capital) {
-                *p-- = digits_cap[num % radix];
-            }
-            else {
-                *p-- = digits[num % radix];
-            }
-            num /= radix;
+        char *end = &num2str[NUM2STR_BUFSIZ];
+        switch (radix) {
+            case 8:  p = _utoa_pow2(end, num, 3, _digits); break;
+            case 16: p = _utoa_pow2(end, num, 4, (capital) ? _digits_cap : _digits); break;
+            default: p = _utoa_dec(end, num); break;
         }
-
-        len = &num2str[NUM2STR_BUFSIZ] - (p+1);
-
+        int num_len = end - p;
+        len = num_len;
 
         // count the number of zeros needed for precision
         // keep track of total string length
         int num_zeros = 0;
-        while (prec > len) {
-            num_zeros++;
-            len++;
+        if (prec > len) {
+            num_zeros = prec - len;
+            len = prec;
         }
 
         // determine sign char, tally new length
@@ -549,53 +666,44 @@ do { \
         //
 
         // handle right justification
-        if (!ljustify) {
+        if (!ljustify && width > len) {
             if (zeropad && default_prec) {
-                while (width > len) { num_zeros++; len++; }
+                num_zeros += width - len;
             }
             else {
-                while (width > len) {
-                    width--; _putchar(' ');   // spaces always come first...
-                }
+                _pad(_spaces, width - len);     // spaces always come first...
             }
+            len = width;
         }
 
         // write sign char
         if (sign_char) {
-            _putchar(sign_char);              // followed by the sign...
+            _emit(&sign_char, 1);               // followed by the sign...
         }
 
         // write any radix prefixes
         if (altflag) {
             if (radix == 16 && !zero) {
-                _putchar('0');
-                _putchar((capital)?'X':'x');  // then the radix prefix...
+                _emit((capital) ? "0X" : "0x", 2);  // then the radix prefix...
             }
         }
 
         // write any leading zeros
-        while (num_zeros-- > 0) {
-            _putchar('0');                    // then any leading zeros...
-        }
+        _pad(_zeros, num_zeros);                // then any leading zeros...
 
         // write stringifed number
-        while (++p != &num2str[NUM2STR_BUFSIZ]) {
-            _putchar(*p);                     // next, the number itself...
-        }
+        _emit(p, num_len);                      // next, the number itself...
 
         // write padding for left justify
         if (ljustify) {
-            while (width > len) {
-                width--;
-                _putchar(' ');                // and finally, trailing spaces.
-            }
+            _pad(_spaces, width - len);         // and finally, trailing spaces.
         }
     }
 
-    _putchar('\0');
     retval = nwritten;
 
-#undef _putchar
+#undef _emit
+#undef _pad
 
 done:
     return retval;
@@ -23,6 +23,7 @@
 #include <errno.h>
 #include <limits.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -56,14 +57,67 @@ char * strerror(int errnum)
     return _strerr_buf;
 }
 
-void * memcpy(void *restrict dst, const void * restrict src, size_t count)
+//
+// The mem* functions below move bytes until the destination is dword-aligned,
+// move whole dwords with a single rep movsl/stosl, then mop up the tail. Below
+// _REP_MIN bytes the rep startup cost isn't worth it and we go a byte at a
+// time. All of these assume the direction flag is clear on entry, per the ABI;
+// recv_interrupt clears it too, so an IRQ that lands in movsl_down()'s window
+// doesn't run its handlers with DF set.
+//
+
+#define _REP_MIN    64
+
+typedef uint32_t __may_alias _word_t;
+
+static inline void movsl(void *dst, const void *src, size_t count)
+{
+    int d0, d1, d2;
+    __asm__ volatile (
+        "rep movsl"
+        : "=&D"(d0), "=&S"(d1), "=&c"(d2)
+        : "0"(dst), "1"(src), "2"(count)
+        : "memory"
+    );
+}
+
+// copy backwards; 'dst' and 'src' point one past the end of each buffer
+static inline void movsl_down(void *dst, const void *src, size_t count)
+{
+    int d0, d1, d2;
+    __asm__ volatile (
+        "std; rep movsl; cld"
+        : "=&D"(d0), "=&S"(d1), "=&c"(d2)
+        : "0"((char *) dst - 4), "1"((const char *) src - 4), "2"(count)
+        : "memory"
+    );
+}
+
+static inline void stosl(void *dst, uint32_t val, size_t count)
 {
-    // TODO: could be optimized to copy DWORDs...
-    //       or use __builtin_memcpy?
+    int d0, d1;
+    __asm__ volatile (
+        "rep stosl"
+        : "=&D"(d0), "=&c"(d1)
+        : "0"(dst), "1"(count), "a"(val)
+        : "memory"
+    );
+}
 
+void * memcpy(void *restrict dst, const void * restrict src, size_t count)
+{
     char *d = dst;
     const char *s = src;
 
+    if (count >= _REP_MIN) {
+        while ((uintptr_t) d & 3) {
+            *d++ = *s++;
+            count--;
+        }
+        movsl(d, s, count >> 2);
+        d += count & ~3; s += count & ~3;
+        count &= 3;
+    }
     while (count--) {
         *d++ = *s++;
     }
@@ -77,41 +131,48 @@ void * mempcpy(void *restrict dst, const void * restrict src, size_t count)
     return &((char *) dst)[count];
 }
 
-
 void * memmove(void *dst, const void *src, size_t count)
 {
     char *d = dst;
     const char *s = src;
 
-    if (src == dst) {
-        return dst;
+    // a forward copy never reads a byte it has already written as long as
+    // the destination starts before the source; otherwise, if they overlap,
+    // copy backwards from the tail
+    if (d <= s || d >= s + count) {
+        return memcpy(dst, src, count);
     }
 
-    // left overlap, copy forwards from head
-    if (dst < src && dst + count > src) {
-        while (count--) {
-            *d++ = *s++;
+    d += count; s += count;
+    if (count >= _REP_MIN) {
+        while ((uintptr_t) d & 3) {
+            *--d = *--s;
+            count--;
         }
-
-        return dst;
+        movsl_down(d, s, count >> 2);
+        d -= count & ~3; s -= count & ~3;
+        count &= 3;
     }
-
-    // right overlap, copy backwards from tail
-    else if (src < dst && src + count > dst) {
-        d += count; s += count;
-        while (count--) {
-            *--d = *--s;    // evil
-        }
-        return dst;
+    while (count--) {
+        *--d = *--s;
     }
 
-    // no overlap
-    return memcpy(dst, src, count);
+    return dst;
 }
 
 void * memset(void *dst, int c, size_t count)
 {
     char *d = dst;
+
+    if (count >= _REP_MIN) {
+        while ((uintptr_t) d & 3) {
+            *d++ = (char) c;
+            count--;
+        }
+        stosl(d, (uint32_t) (uint8_t) c * 0x01010101u, count >> 2);
+        d += count & ~3;
+        count &= 3;
+    }
     while (count--) {
         *d++ = (char) c;
     }
@@ -121,18 +182,21 @@ void * memset(void *dst, int c, size_t count)
 
 int memcmp(const void *lhs, const void *rhs, size_t count)
 {
-    const char *l = lhs;
-    const char *r = rhs;
+    const unsigned char *l = lhs;
+    const unsigned char *r = rhs;
 
-    if (count == 0) {
-        return 0;
+    // skip past the matching dwords, then find the byte that differs
+    while (count >= 4 && *(const _word_t *) l == *(const _word_t *) r) {
+        l += 4; r += 4; count -= 4;
     }
-
-    while ((*l == *r) && --count) {
-        l++; r++;
+    while (count != 0) {
+        if (*l != *r) {
+            return *l - *r;
+        }
+        l++; r++; count--;
     }
 
-    return *l - *r;
+    return 0;
 }
 
 char * strcpy(char *restrict dst, const char *restrict src)
@@ -164,50 +228,165 @@ char * stpncpy(char *restrict dst, const char *restrict src, size_t count)
     return memset(mempcpy(dst, src, len), 0, count - len);
 }
 
+//
+// The scanning functions below look at a dword at a time using the classic
+// has-zero-byte trick: (w - 0x01010101) & ~w & 0x80808080 is nonzero iff some
+// byte of w is zero. XOR-ing w with a byte repeated four times first finds
+// that byte instead. Aligned dword reads never cross a page boundary, so it's
+// safe to read a little past the end of a string; unaligned reads check first.
+//
+
+#define _ONES       0x01010101u
+#define _HIGHS      0x80808080u
+#define _PAGE_SIZE  4096
+
+#define has_zero(w)         (((w) - _ONES) & ~(w) & _HIGHS)
+#define crosses_page(p)     (((uintptr_t) (p) & (_PAGE_SIZE - 1)) > _PAGE_SIZE - 4)
+
 size_t strlen(const char *str)
 {
-    size_t len = 0;
-    while ((*str++) != '\0') {
-        len++;
+    const char *p = str;
+
+    while ((uintptr_t) p & 3) {
+        if (*p == '\0') {
+            return p - str;
+        }
+        p++;
+    }
+
+    const _word_t *w = (const _word_t *) p;
+    while (!has_zero(*w)) {
+        w++;
+    }
+
+    p = (const char *) w;
+    while (*p != '\0') {
+        p++;
     }
 
-    return len;
+    return p - str;
 }
 
 size_t strnlen(const char *str, size_t maxlen)
 {
-    size_t len = 0;
-    while (maxlen-- && (*str++) != '\0') {
-        len++;
+    const char *p = str;
+
+    while (maxlen != 0 && ((uintptr_t) p & 3)) {
+        if (*p == '\0') {
+            return p - str;
+        }
+        p++; maxlen--;
+    }
+    while (maxlen >= 4 && !has_zero(*(const _word_t *) p)) {
+        p += 4; maxlen -= 4;
+    }
+    while (maxlen != 0 && *p != '\0') {
+        p++; maxlen--;
     }
 
-    return len;
+    return p - str;
 }
 
 int strcmp(const char *lhs, const char *rhs)
 {
-    while (*lhs && (*lhs == *rhs)) {
-        lhs++; rhs++;
-    }
+    const unsigned char *l = (const unsigned char *) lhs;
+    const unsigned char *r = (const unsigned char *) rhs;
+
+    for (;;) {
+        // compare a dword at a time while lhs is aligned; rhs may not be
+        if (((uintptr_t) l & 3) == 0 && !crosses_page(r)) {
+            uint32_t lw = *(const _word_t *) l;
+            if (lw == *(const _word_t *) r && !has_zero(lw)) {
+                l += 4; r += 4;
+                continue;
+            }
+        }
 
-    return *lhs - *rhs;
+        if (*l != *r || *l == '\0') {
+            return *l - *r;
+        }
+        l++; r++;
+    }
 }
 
 int strncmp(const char *lhs, const char *rhs, size_t count)
 {
-    if (count == 0) {
-        return 0;
+    const unsigned char *l = (const unsigned char *) lhs;
+    const unsigned char *r = (const unsigned char *) rhs;
+
+    while (count != 0) {
+        if (count >= 4 && ((uintptr_t) l & 3) == 0 && !crosses_page(r)) {
+            uint32_t lw = *(const _word_t *) l;
+            if (lw == *(const _word_t *) r && !has_zero(lw)) {
+                l += 4; r += 4; count -= 4;
+                continue;
+            }
+        }
+
+        if (*l != *r || *l == '\0') {
+            return *l - *r;
+        }
+        l++; r++; count--;
     }
 
-    int diff = 0;
-    for (int i = 0; i < count; i++, lhs++, rhs++) {
-        diff = (*lhs - *rhs);
-        if (diff != 0 || !(*lhs) || !(*rhs)) {
-            break;
+    return 0;
+}
+
+void * memchr(const void *ptr, int c, size_t count)
+{
+    const unsigned char *p = ptr;
+    unsigned char ch = (unsigned char) c;
+    uint32_t pattern = ch * _ONES;
+
+    while (count != 0 && ((uintptr_t) p & 3)) {
+        if (*p == ch) {
+            return (void *) p;
+        }
+        p++; count--;
+    }
+    while (count >= 4 && !has_zero(*(const _word_t *) p ^ pattern)) {
+        p += 4; count -= 4;
+    }
+    while (count != 0) {
+        if (*p == ch) {
+            return (void *) p;
         }
+        p++; count--;
     }
 
-    return diff;
+    return NULL;
+}
+
+char * strchr(const char *str, int c)
+{
+    const char *p = str;
+    char ch = (char) c;
+    uint32_t pattern = (unsigned char) ch * _ONES;
+
+    while ((uintptr_t) p & 3) {
+        if (*p == ch) {
+            return (char *) p;
+        }
+        if (*p == '\0') {
+            return NULL;
+        }
+        p++;
+    }
+
+    // stop at the dword holding either the char or the terminator
+    const _word_t *w = (const _word_t *) p;
+    while (!has_zero(*w) && !has_zero(*w ^ pattern)) {
+        w++;
+    }
+
+    for (p = (const char *) w; ; p++) {
+        if (*p == ch) {
+            return (char *) p;
+        }
+        if (*p == '\0') {
+            return NULL;
+        }
+    }
 }
 
 char * strcat(char *restrict dst, const char *restrict src)
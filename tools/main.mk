@@ -10,6 +10,7 @@ BUILD_DIR  := ../obj/tools
 
 SUBMAKEFILES := \
     fatfs/fatfs.mk \
+    tracedump/tracedump.mk \
 
 CC  := gcc
 CXX := g++
@@ -0,0 +1,406 @@
+/* =============================================================================
+ * Copyright (C) 2020-2025 Wes Hampson. All Rights Reserved.
+ *
+ * This file is part of the OH-WES Operating System.
+ * OH-WES is free software; you may redistribute it and/or modify it under the
+ * terms of the GNU GPLv2. See the LICENSE file in the root of this repository.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ * -----------------------------------------------------------------------------
+ *         File: tools/tracedump/tracedump.c
+ *      Created: October 16, 2026
+ *       Author: Wes Hampson
+ * -----------------------------------------------------------------------------
+ * Decodes kernel trace records against kernel.elf. Input is either the raw
+ * contents of /dev/trace, or (with -l) a captured console log containing the
+ * output of the trace sysrq.
+ *
+ * usage: tracedump [-l] kernel.elf [tracefile]
+ * =============================================================================
+ */
+
+#include <elf.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TRACE_NR_ARGS   5
+
+// must match struct trace_record in src/include/kernel/trace.h
+struct trace_record
+{
+    uint64_t tsc;
+    uint32_t event;
+    uint32_t args[TRACE_NR_ARGS];
+};
+
+struct symbol
+{
+    uint32_t addr;
+    uint32_t size;
+    const char *name;
+};
+
+static const char *s_ProgramName;
+
+static uint8_t *s_Image;            // kernel.elf contents
+static size_t s_ImageSize;
+static Elf32_Shdr *s_Sections;
+static int s_NumSections;
+static struct symbol *s_Symbols;    // sorted by address
+static int s_NumSymbols;
+
+static bool s_HaveFirst;
+static uint64_t s_FirstTsc;
+static uint64_t s_PrevTsc;
+
+// -----------------------------------------------------------------------------
+// ELF Lookup
+// -----------------------------------------------------------------------------
+
+static int CompareSymbols(const void *a, const void *b)
+{
+    const struct symbol *sa = (const struct symbol *) a;
+    const struct symbol *sb = (const struct symbol *) b;
+    return (sa->addr > sb->addr) - (sa->addr < sb->addr);
+}
+
+static bool LoadElf(const char *path)
+{
+    FILE *fp = fopen(path, "rb");
+    if (!fp)
+    {
+        perror(path);
+        return false;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    s_ImageSize = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    s_Image = (uint8_t *) malloc(s_ImageSize);
+    if (!s_Image || fread(s_Image, 1, s_ImageSize, fp) != s_ImageSize)
+    {
+        fprintf(stderr, "%s: %s: read failed\n", s_ProgramName, path);
+        fclose(fp);
+        return false;
+    }
+    fclose(fp);
+
+    Elf32_Ehdr *ehdr = (Elf32_Ehdr *) s_Image;
+    if (s_ImageSize < sizeof(Elf32_Ehdr) ||
+        memcmp(ehdr->e_ident, ELFMAG, SELFMAG) != 0 ||
+        ehdr->e_ident[EI_CLASS] != ELFCLASS32 ||
+        ehdr->e_shoff + ehdr->e_shnum * sizeof(Elf32_Shdr) > s_ImageSize)
+    {
+        fprintf(stderr, "%s: %s: not a 32-bit ELF file\n", s_ProgramName, path);
+        return false;
+    }
+
+    s_Sections = (Elf32_Shdr *) (s_Image + ehdr->e_shoff);
+    s_NumSections = ehdr->e_shnum;
+
+    // collect function and object symbols for %pS
+    for (int i = 0; i < s_NumSections; i++)
+    {
+        Elf32_Shdr *sh = &s_Sections[i];
+        if (sh->sh_type != SHT_SYMTAB || sh->sh_link >= (Elf32_Word) s_NumSections)
+        {
+            continue;
+        }
+
+        Elf32_Sym *syms = (Elf32_Sym *) (s_Image + sh->sh_offset);
+        const char *strtab = (const char *) (s_Image + s_Sections[sh->sh_link].sh_offset);
+        int count = sh->sh_size / sizeof(Elf32_Sym);
+
+        s_Symbols = (struct symbol *) calloc(count, sizeof(struct symbol));
+        for (int k = 0; k < count; k++)
+        {
+            int type = ELF32_ST_TYPE(syms[k].st_info);
+            if ((type != STT_FUNC && type != STT_OBJECT) || syms[k].st_value == 0)
+            {
+                continue;
+            }
+            s_Symbols[s_NumSymbols].addr = syms[k].st_value;
+            s_Symbols[s_NumSymbols].size = syms[k].st_size;
+            s_Symbols[s_NumSymbols].name = strtab + syms[k].st_name;
+            s_NumSymbols++;
+        }
+        qsort(s_Symbols, s_NumSymbols, sizeof(struct symbol), CompareSymbols);
+        break;
+    }
+
+    return true;
+}
+
+// find a NUL-terminated string at a kernel virtual address
+static const char * LookupString(uint32_t addr)
+{
+    for (int i = 0; i < s_NumSections; i++)
+    {
+        Elf32_Shdr *sh = &s_Sections[i];
+        if (sh->sh_type != SHT_PROGBITS || !(sh->sh_flags & SHF_ALLOC))
+        {
+            continue;
+        }
+        if (addr < sh->sh_addr || addr >= sh->sh_addr + sh->sh_size)
+        {
+            continue;
+        }
+
+        const char *str = (const char *) (s_Image + sh->sh_offset + (addr - sh->sh_addr));
+        size_t maxlen = sh->sh_size - (addr - sh->sh_addr);
+        if (memchr(str, '\0', maxlen) == NULL)
+        {
+            return NULL;
+        }
+        return str;
+    }
+
+    return NULL;
+}
+
+static const struct symbol * LookupSymbol(uint32_t addr)
+{
+    int lo = 0;
+    int hi = s_NumSymbols - 1;
+    const struct symbol *best = NULL;
+
+    // last symbol at or below the address
+    while (lo <= hi)
+    {
+        int mid = lo + (hi - lo) / 2;
+        if (s_Symbols[mid].addr <= addr)
+        {
+            best = &s_Symbols[mid];
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid - 1;
+        }
+    }
+
+    if (best && best->size != 0 && addr >= best->addr + best->size)
+    {
+        return NULL;
+    }
+    return best;
+}
+
+// -----------------------------------------------------------------------------
+// Record Decoding
+// -----------------------------------------------------------------------------
+
+static void PrintRecord(const struct trace_record *rec)
+{
+    if (!s_HaveFirst)
+    {
+        s_FirstTsc = s_PrevTsc = rec->tsc;
+        s_HaveFirst = true;
+    }
+
+    printf("%12" PRIu64 " %+10" PRId64 "  ",
+        rec->tsc - s_FirstTsc, (int64_t) (rec->tsc - s_PrevTsc));
+    s_PrevTsc = rec->tsc;
+
+    const char *fmt = LookupString(rec->event);
+    if (!fmt)
+    {
+        printf("unknown event %08X: %08X %08X %08X %08X %08X\n", rec->event,
+            rec->args[0], rec->args[1], rec->args[2], rec->args[3], rec->args[4]);
+        return;
+    }
+
+    int argi = 0;
+    for (const char *p = fmt; *p != '\0'; p++)
+    {
+        if (*p != '%')
+        {
+            putchar(*p);
+            continue;
+        }
+        if (p[1] == '%')
+        {
+            putchar('%');
+            p++;
+            continue;
+        }
+
+        // copy flags and width, drop length modifiers; args are all 32 bits
+        char spec[16];
+        int n = 0;
+        spec[n++] = *p++;
+        while (*p != '\0' && strchr("-+ #0123456789", *p) && n < (int) sizeof(spec) - 2)
+        {
+            spec[n++] = *p++;
+        }
+        while (*p == 'l' || *p == 'h')
+        {
+            p++;
+        }
+        if (*p == '\0')
+        {
+            break;
+        }
+
+        uint32_t arg = (argi < TRACE_NR_ARGS) ? rec->args[argi++] : 0;
+        spec[n++] = *p;
+        spec[n] = '\0';
+
+        switch (*p)
+        {
+            case 'd':
+            case 'i':
+                printf(spec, (int32_t) arg);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+            case 'c':
+                printf(spec, arg);
+                break;
+            case 's':
+            {
+                const char *str = LookupString(arg);
+                if (str)
+                {
+                    spec[n - 1] = 's';
+                    printf(spec, str);
+                }
+                else
+                {
+                    printf("<%08X>", arg);
+                }
+                break;
+            }
+            case 'p':
+            {
+                const struct symbol *sym = NULL;
+                if (p[1] == 'S')
+                {
+                    sym = LookupSymbol(arg);
+                    p++;
+                }
+                if (sym)
+                {
+                    printf("%s+0x%X", sym->name, arg - sym->addr);
+                }
+                else
+                {
+                    printf("%08X", arg);
+                }
+                break;
+            }
+            default:
+                printf("%s", spec);
+                break;
+        }
+    }
+    putchar('\n');
+}
+
+static int DecodeBinary(FILE *fp)
+{
+    struct trace_record rec;
+    int count = 0;
+
+    while (fread(&rec, sizeof(rec), 1, fp) == 1)
+    {
+        PrintRecord(&rec);
+        count++;
+    }
+
+    return count;
+}
+
+static int DecodeLog(FILE *fp)
+{
+    char line[512];
+    int count = 0;
+
+    // trace: TTTTTTTTTTTTTTTT EEEEEEEE AAAAAAAA AAAAAAAA AAAAAAAA AAAAAAAA AAAAAAAA
+    while (fgets(line, sizeof(line), fp))
+    {
+        const char *p = strstr(line, "trace: ");
+        if (!p)
+        {
+            continue;
+        }
+
+        struct trace_record rec;
+        int n = sscanf(p, "trace: %16" SCNx64 " %8" SCNx32 " %8" SCNx32 " %8" SCNx32
+                " %8" SCNx32 " %8" SCNx32 " %8" SCNx32,
+            &rec.tsc, &rec.event, &rec.args[0], &rec.args[1],
+            &rec.args[2], &rec.args[3], &rec.args[4]);
+        if (n != 2 + TRACE_NR_ARGS)
+        {
+            continue;   // begin/end markers, or noise
+        }
+
+        PrintRecord(&rec);
+        count++;
+    }
+
+    return count;
+}
+
+static void PrintUsage(void)
+{
+    fprintf(stderr, "usage: %s [-l] kernel.elf [tracefile]\n", s_ProgramName);
+    fprintf(stderr, "  Decodes binary records read from /dev/trace, or with -l, the\n");
+    fprintf(stderr, "  trace dump lines in a captured console log. Reads stdin if\n");
+    fprintf(stderr, "  no trace file is given.\n");
+}
+
+int main(int argc, char **argv)
+{
+    bool logMode = false;
+    int argi = 1;
+
+    s_ProgramName = argv[0];
+
+    if (argi < argc && strcmp(argv[argi], "-l") == 0)
+    {
+        logMode = true;
+        argi++;
+    }
+    if (argi >= argc || argc - argi > 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    if (!LoadElf(argv[argi]))
+    {
+        return 1;
+    }
+
+    FILE *fp = stdin;
+    if (argi + 1 < argc)
+    {
+        fp = fopen(argv[argi + 1], logMode ? "r" : "rb");
+        if (!fp)
+        {
+            perror(argv[argi + 1]);
+            return 1;
+        }
+    }
+
+    int count = logMode ? DecodeLog(fp) : DecodeBinary(fp);
+    fprintf(stderr, "%d records\n", count);
+
+    if (fp != stdin)
+    {
+        fclose(fp);
+    }
+    return 0;
+}
@@ -0,0 +1,4 @@
+TARGET = tracedump
+
+SOURCES = \
+  tracedump.c